@@ -1,10 +1,14 @@
 #ifndef SIGHTREAD_CHARTPARSER_HPP
 #define SIGHTREAD_CHARTPARSER_HPP
 
+#include <filesystem>
 #include <set>
 #include <string_view>
 
+#include "sightread/chartstreamparser.hpp"
 #include "sightread/metadata.hpp"
+#include "sightread/parselimits.hpp"
+#include "sightread/parseresult.hpp"
 #include "sightread/soloparsingbehaviour.hpp"
 #include "sightread/song.hpp"
 #include "sightread/songparts.hpp"
@@ -16,6 +20,10 @@ private:
     std::set<SightRead::Instrument> m_permitted_instruments;
     SightRead::SoloParsingBehaviour m_solo_parsing_behaviour;
     bool m_allow_open_chords;
+    unsigned int m_max_threads;
+    SightRead::ParseLimits m_limits;
+
+    [[nodiscard]] SightRead::Detail::ChartConverter converter() const;
 
 public:
     explicit ChartParser(SightRead::Metadata metadata);
@@ -24,7 +32,25 @@ public:
     ChartParser&
     solo_parsing_behaviour(SightRead::SoloParsingBehaviour behaviour);
     ChartParser& allow_open_chords(bool allow_open_chords);
+    // Sets the number of threads sections may be parsed and converted on by
+    // parse and parse_file, where 0 means one per hardware thread. The default
+    // is 1, which parses serially.
+    ChartParser& max_threads(unsigned int max_threads);
+    // Sets the limits files are parsed within. parse throws
+    // SightRead::ParseLimitError if one is exceeded.
+    ChartParser& limits(SightRead::ParseLimits limits);
     [[nodiscard]] SightRead::Song parse(std::string_view data) const;
+    // Like parse, but returns a diagnostic instead of throwing if data cannot
+    // be parsed. Finding a malformed line does not throw internally, and the
+    // diagnostic gives the byte offset of the line in data if data is UTF-8.
+    [[nodiscard]] SightRead::ParseResult<SightRead::Song>
+    try_parse(std::string_view data) const;
+    // Parses the file at path by mapping it into memory rather than reading
+    // it into a buffer.
+    [[nodiscard]] SightRead::Song
+    parse_file(const std::filesystem::path& path) const;
+    // Returns a parser for a file that is supplied in pieces.
+    [[nodiscard]] SightRead::ChartStreamParser stream() const;
 };
 }
 
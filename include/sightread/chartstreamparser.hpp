@@ -0,0 +1,50 @@
+#ifndef SIGHTREAD_CHARTSTREAMPARSER_HPP
+#define SIGHTREAD_CHARTSTREAMPARSER_HPP
+
+#include <memory>
+#include <string_view>
+
+#include "sightread/parselimits.hpp"
+#include "sightread/song.hpp"
+
+namespace SightRead::Detail {
+class ChartConverter;
+}
+
+namespace SightRead {
+class ChartParser;
+
+// Parses a .chart file that arrives in pieces, such as from a pipe or a
+// decompressor. Each section is converted as soon as its closing brace has
+// been pushed, so conversion overlaps with reading the rest of the file.
+// Text that is not UTF-8 is read as Latin-1 as ChartParser::parse reads it,
+// but unlike ChartParser::parse UTF-16 input is not supported. Create one with
+// ChartParser::stream.
+class ChartStreamParser {
+private:
+    class Impl;
+
+    std::unique_ptr<Impl> m_impl;
+
+    // The limits apply to the whole stream, and the time budget runs from
+    // construction.
+    ChartStreamParser(const SightRead::Detail::ChartConverter& converter,
+                      SightRead::ParseLimits limits);
+
+    friend class ChartParser;
+
+public:
+    ChartStreamParser(ChartStreamParser&& other) noexcept;
+    ChartStreamParser& operator=(ChartStreamParser&& other) noexcept;
+    ~ChartStreamParser();
+
+    // Throws SightRead::ParseLimitError once a limit is exceeded.
+    void push(std::string_view data);
+    // Converts what is left of the file and returns the song, after which the
+    // parser must not be used again. Throws SightRead::ParseError if the file
+    // ends partway through a section.
+    [[nodiscard]] SightRead::Song finish();
+};
+}
+
+#endif
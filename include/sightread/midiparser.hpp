@@ -2,10 +2,13 @@
 #define SIGHTREAD_MIDIPARSER_HPP
 
 #include <cstdint>
+#include <filesystem>
 #include <set>
 #include <span>
 
 #include "sightread/metadata.hpp"
+#include "sightread/parselimits.hpp"
+#include "sightread/parseresult.hpp"
 #include "sightread/song.hpp"
 #include "sightread/songparts.hpp"
 
@@ -17,6 +20,8 @@ private:
     bool m_permit_solos;
     bool m_allow_open_chords;
     bool m_use_sustain_cutoff_threshold;
+    unsigned int m_max_threads;
+    SightRead::ParseLimits m_limits;
 
 public:
     explicit MidiParser(SightRead::Metadata metadata);
@@ -25,8 +30,23 @@ public:
     MidiParser& parse_solos(bool permit_solos);
     MidiParser& allow_open_chords(bool allow_open_chords);
     MidiParser& use_sustain_cutoff_threshold(bool use_sustain_cutoff_threshold);
+    // Sets the number of threads tracks may be decoded and converted on, where
+    // 0 means one per hardware thread. The default is 1, which parses serially.
+    MidiParser& max_threads(unsigned int max_threads);
+    // Sets the limits files are parsed within. parse throws
+    // SightRead::ParseLimitError if one is exceeded.
+    MidiParser& limits(SightRead::ParseLimits limits);
     [[nodiscard]] SightRead::Song
     parse(std::span<const std::uint8_t> data) const;
+    // Like parse, but returns a diagnostic instead of throwing if data cannot
+    // be parsed. Only diagnostics for a malformed header or track chunk have
+    // byte offsets.
+    [[nodiscard]] SightRead::ParseResult<SightRead::Song>
+    try_parse(std::span<const std::uint8_t> data) const;
+    // Parses the file at path by mapping it into memory rather than reading
+    // it into a buffer.
+    [[nodiscard]] SightRead::Song
+    parse_file(const std::filesystem::path& path) const;
 };
 }
 
@@ -0,0 +1,38 @@
+#ifndef SIGHTREAD_PARSELIMITS_HPP
+#define SIGHTREAD_PARSELIMITS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+#include "sightread/tempomap.hpp"
+
+namespace SightRead {
+// Bounds on the work done to parse one file, for untrusted input. Limits that
+// are not set are not enforced.
+//
+// Counts are checked once a file has been tokenised and before it is
+// converted, since conversion is where the cost can grow faster than the size
+// of the file. Events are the lines of .chart sections, the events of MIDI
+// tracks, and the items and array and struct elements of .mid.qb files. Only
+// sections and MIDI events that are kept count towards their limits, but MIDI
+// tracks are counted before any are decoded, so every track chunk counts. The
+// time budget is measured from the start of the parse and checked between
+// stages, before each track is converted, and within the passes over a track
+// whose cost grows faster than the track, such as forming solos.
+struct ParseLimits {
+    std::optional<std::size_t> max_payload_bytes;
+    std::optional<std::size_t> max_sections;
+    std::optional<std::size_t> max_tracks;
+    std::optional<std::size_t> max_events;
+    std::optional<std::chrono::steady_clock::duration> time_budget;
+};
+
+// Thrown when a file exceeds the ParseLimits it is parsed with.
+class ParseLimitError : public ParseError {
+public:
+    using ParseError::ParseError;
+};
+}
+
+#endif
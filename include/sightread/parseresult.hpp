@@ -0,0 +1,105 @@
+#ifndef SIGHTREAD_PARSERESULT_HPP
+#define SIGHTREAD_PARSERESULT_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+
+#include "sightread/parselimits.hpp"
+#include "sightread/tempomap.hpp"
+
+namespace SightRead {
+enum class ParseErrorCategory {
+    // The file's text encoding could not be decoded.
+    Encoding,
+    // The file is not laid out as its format requires.
+    Syntax,
+    // The file is well formed but does not describe a usable song, such as
+    // one with no notes or an invalid tempo map.
+    Content,
+    // The file exceeds the ParseLimits it was parsed with.
+    LimitExceeded
+};
+
+// Why a file could not be parsed. byte_offset is the position in the parsed
+// data of the problem where it is known.
+struct ParseDiagnostic {
+    ParseErrorCategory category;
+    std::optional<std::size_t> byte_offset;
+    std::string message;
+};
+
+// Either a parsed T or the diagnostic explaining why it could not be parsed.
+// The interface follows C++23's std::expected<T, ParseDiagnostic>.
+template <typename T> class ParseResult {
+private:
+    std::variant<T, ParseDiagnostic> m_result;
+
+    void throw_if_error() const
+    {
+        if (has_value()) {
+            return;
+        }
+        if (error().category == ParseErrorCategory::LimitExceeded) {
+            throw SightRead::ParseLimitError(error().message);
+        }
+        throw SightRead::ParseError(error().message);
+    }
+
+public:
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    ParseResult(T value)
+        : m_result {std::in_place_index<0>, std::move(value)}
+    {
+    }
+
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    ParseResult(ParseDiagnostic diagnostic)
+        : m_result {std::in_place_index<1>, std::move(diagnostic)}
+    {
+    }
+
+    [[nodiscard]] bool has_value() const { return m_result.index() == 0; }
+    explicit operator bool() const { return has_value(); }
+
+    // Throws SightRead::ParseError with the diagnostic's message if there is
+    // no value, or SightRead::ParseLimitError for exceeded limits.
+    [[nodiscard]] const T& value() const&
+    {
+        throw_if_error();
+        return std::get<0>(m_result);
+    }
+
+    [[nodiscard]] T&& value() &&
+    {
+        throw_if_error();
+        return std::get<0>(std::move(m_result));
+    }
+
+    // operator* and operator-> require there to be a value, and error requires
+    // there not to be.
+    [[nodiscard]] const T& operator*() const&
+    {
+        return *std::get_if<0>(&m_result);
+    }
+    [[nodiscard]] T& operator*() & { return *std::get_if<0>(&m_result); }
+    [[nodiscard]] const T* operator->() const
+    {
+        return std::get_if<0>(&m_result);
+    }
+    [[nodiscard]] T* operator->() { return std::get_if<0>(&m_result); }
+
+    [[nodiscard]] const ParseDiagnostic& error() const
+    {
+        return *std::get_if<1>(&m_result);
+    }
+    [[nodiscard]] ParseDiagnostic& error()
+    {
+        return *std::get_if<1>(&m_result);
+    }
+};
+}
+
+#endif
@@ -2,10 +2,13 @@
 #define SIGHTREAD_QBMIDIPARSER_HPP
 
 #include <cstdint>
+#include <filesystem>
 #include <span>
 #include <string_view>
 
 #include "sightread/metadata.hpp"
+#include "sightread/parselimits.hpp"
+#include "sightread/parseresult.hpp"
 #include "sightread/song.hpp"
 
 namespace SightRead {
@@ -16,11 +19,23 @@ private:
     SightRead::Metadata m_metadata;
     Console m_console;
     std::string_view m_short_name;
+    SightRead::ParseLimits m_limits;
 
 public:
     QbMidiParser(SightRead::Metadata metadata, std::string_view short_name,
                  Console console);
+    // Sets the limits files are parsed within. parse throws
+    // SightRead::ParseLimitError if one is exceeded.
+    QbMidiParser& limits(SightRead::ParseLimits limits);
     SightRead::Song parse(std::span<const std::uint8_t> data) const;
+    // Like parse, but returns a diagnostic instead of throwing if data cannot
+    // be parsed. Diagnostics do not have byte offsets.
+    [[nodiscard]] SightRead::ParseResult<SightRead::Song>
+    try_parse(std::span<const std::uint8_t> data) const;
+    // Parses the file at path by mapping it into memory rather than reading
+    // it into a buffer.
+    [[nodiscard]] SightRead::Song
+    parse_file(const std::filesystem::path& path) const;
 };
 }
 
@@ -1,16 +1,41 @@
+#include <cstddef>
+#include <optional>
+#include <string>
 #include <utility>
 
 #include "sightread/chartparser.hpp"
 #include "sightread/detail/chart.hpp"
 #include "sightread/detail/chartconverter.hpp"
+#include "sightread/detail/limitchecker.hpp"
+#include "sightread/detail/mappedfile.hpp"
 #include "sightread/detail/stringutil.hpp"
 
+namespace {
+std::optional<SightRead::ParseDiagnostic>
+check_chart(const SightRead::Detail::LimitChecker& limit_checker,
+            const SightRead::Detail::Chart& chart)
+{
+    std::size_t event_count = 0;
+    for (const auto& section : chart.sections) {
+        event_count += section.event_count();
+    }
+    if (auto exceeded = limit_checker.check_sections(chart.sections.size())) {
+        return exceeded;
+    }
+    if (auto exceeded = limit_checker.check_events(event_count)) {
+        return exceeded;
+    }
+    return limit_checker.check_time();
+}
+}
+
 SightRead::ChartParser::ChartParser(SightRead::Metadata metadata)
     : m_metadata {std::move(metadata)}
     , m_permitted_instruments {SightRead::all_instruments()}
     , m_solo_parsing_behaviour {SightRead::SoloParsingBehaviour::
                                     PreferLaterStarts}
     , m_allow_open_chords {true}
+    , m_max_threads {1}
 {
 }
 
@@ -35,13 +60,82 @@ SightRead::ChartParser::allow_open_chords(bool allow_open_chords)
     return *this;
 }
 
+SightRead::ChartParser&
+SightRead::ChartParser::max_threads(unsigned int max_threads)
+{
+    m_max_threads = max_threads;
+    return *this;
+}
+
+SightRead::ChartParser&
+SightRead::ChartParser::limits(SightRead::ParseLimits limits)
+{
+    m_limits = std::move(limits);
+    return *this;
+}
+
+SightRead::Detail::ChartConverter SightRead::ChartParser::converter() const
+{
+    auto converter = SightRead::Detail::ChartConverter(m_metadata);
+    converter.permit_instruments(m_permitted_instruments)
+        .solo_parsing_behaviour(m_solo_parsing_behaviour)
+        .allow_open_chords(m_allow_open_chords)
+        .max_threads(m_max_threads);
+    return converter;
+}
+
 SightRead::Song SightRead::ChartParser::parse(std::string_view data) const
 {
-    const auto utf8_string = SightRead::Detail::to_utf8_string(data);
-    const auto chart = SightRead::Detail::parse_chart(utf8_string);
-    const auto converter = SightRead::Detail::ChartConverter(m_metadata)
-                               .permit_instruments(m_permitted_instruments)
-                               .solo_parsing_behaviour(m_solo_parsing_behaviour)
-                               .allow_open_chords(m_allow_open_chords);
-    return converter.convert(chart);
+    return try_parse(data).value();
+}
+
+SightRead::ParseResult<SightRead::Song>
+SightRead::ChartParser::try_parse(std::string_view data) const
+{
+    const SightRead::Detail::LimitChecker limit_checker {m_limits};
+    if (auto exceeded = limit_checker.check_payload(data.size())) {
+        return std::move(*exceeded);
+    }
+    std::string utf8_buffer;
+    const auto utf8_string
+        = SightRead::Detail::try_to_utf8_view(data, utf8_buffer);
+    if (!utf8_string.has_value()) {
+        return utf8_string.error();
+    }
+    auto converter = this->converter();
+    converter.limit_checker(limit_checker);
+    const auto chart = SightRead::Detail::try_parse_chart(
+        *utf8_string,
+        [&](std::string_view section_name) {
+            return converter.is_section_used(section_name);
+        },
+        m_max_threads);
+    if (!chart.has_value()) {
+        auto diagnostic = chart.error();
+        // Offsets into text converted from another encoding do not correspond
+        // to positions in data.
+        if (utf8_string->data() == utf8_buffer.data()) {
+            diagnostic.byte_offset.reset();
+        } else if (diagnostic.byte_offset.has_value()) {
+            *diagnostic.byte_offset
+                += static_cast<std::size_t>(utf8_string->data() - data.data());
+        }
+        return diagnostic;
+    }
+    if (auto exceeded = check_chart(limit_checker, *chart)) {
+        return std::move(*exceeded);
+    }
+    return converter.try_convert(*chart);
+}
+
+SightRead::Song
+SightRead::ChartParser::parse_file(const std::filesystem::path& path) const
+{
+    const SightRead::Detail::MappedFile file {path};
+    return parse(file.chars());
+}
+
+SightRead::ChartStreamParser SightRead::ChartParser::stream() const
+{
+    return SightRead::ChartStreamParser {converter(), m_limits};
 }
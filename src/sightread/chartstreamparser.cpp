@@ -0,0 +1,156 @@
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sightread/chartstreamparser.hpp"
+#include "sightread/detail/chart.hpp"
+#include "sightread/detail/chartconverter.hpp"
+#include "sightread/detail/limitchecker.hpp"
+#include "sightread/songparts.hpp"
+
+namespace {
+constexpr std::string_view UTF8_BOM = "\xEF\xBB\xBF";
+constexpr std::string_view UTF16LE_BOM = "\xFF\xFE";
+constexpr std::string_view UTF16BE_BOM = "\xFE\xFF";
+
+bool could_start_bom(std::string_view start)
+{
+    for (const auto bom : {UTF8_BOM, UTF16LE_BOM, UTF16BE_BOM}) {
+        if (start.size() < bom.size() && bom.starts_with(start)) {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+class SightRead::ChartStreamParser::Impl {
+private:
+    SightRead::Detail::ChartConverter m_converter;
+    SightRead::Detail::ChartSectionReader m_reader;
+    SightRead::Song m_song;
+    std::string m_start;
+    bool m_has_checked_encoding;
+    SightRead::Detail::LimitChecker m_limit_checker;
+    std::size_t m_payload_bytes {0};
+    std::size_t m_section_count {0};
+    std::size_t m_event_count {0};
+
+    void push_sections(std::string_view data);
+    void convert_sections(
+        const std::vector<SightRead::Detail::ChartSection>& sections);
+
+public:
+    Impl(const SightRead::Detail::ChartConverter& converter,
+         SightRead::ParseLimits limits);
+    void push(std::string_view data);
+    SightRead::Song finish();
+};
+
+SightRead::ChartStreamParser::Impl::Impl(
+    const SightRead::Detail::ChartConverter& converter,
+    SightRead::ParseLimits limits)
+    : m_converter {converter}
+    // The Impl stays where it was allocated when the parser is moved, so the
+    // reader can refer to its converter.
+    , m_reader {[this](std::string_view section_name) {
+        return m_converter.is_section_used(section_name);
+    }}
+    , m_song {m_converter.new_song()}
+    , m_has_checked_encoding {false}
+    , m_limit_checker {std::move(limits)}
+{
+    m_converter.limit_checker(m_limit_checker);
+}
+
+void SightRead::ChartStreamParser::Impl::push_sections(std::string_view data)
+{
+    convert_sections(m_reader.push(data));
+}
+
+void SightRead::ChartStreamParser::Impl::convert_sections(
+    const std::vector<SightRead::Detail::ChartSection>& sections)
+{
+    m_section_count += sections.size();
+    for (const auto& section : sections) {
+        m_event_count += section.event_count();
+    }
+    SightRead::Detail::throw_on_exceeded_limit(
+        m_limit_checker.check_sections(m_section_count));
+    SightRead::Detail::throw_on_exceeded_limit(
+        m_limit_checker.check_events(m_event_count));
+    SightRead::Detail::throw_on_exceeded_limit(m_limit_checker.check_time());
+    for (const auto& section : sections) {
+        m_converter.convert_section(m_song, section);
+    }
+}
+
+void SightRead::ChartStreamParser::Impl::push(std::string_view data)
+{
+    m_payload_bytes += data.size();
+    SightRead::Detail::throw_on_exceeded_limit(
+        m_limit_checker.check_payload(m_payload_bytes));
+    if (m_has_checked_encoding) {
+        push_sections(data);
+        return;
+    }
+
+    // A BOM can be split across pushes, so hold back the start of the file
+    // until it is clear whether it has one.
+    m_start.append(data);
+    if (could_start_bom(m_start)) {
+        return;
+    }
+    if (m_start.starts_with(UTF16LE_BOM) || m_start.starts_with(UTF16BE_BOM)) {
+        throw SightRead::ParseError("Streamed .chart files must be UTF-8");
+    }
+    std::string_view start {m_start};
+    if (start.starts_with(UTF8_BOM)) {
+        start.remove_prefix(UTF8_BOM.size());
+        m_reader.assume_utf8();
+    }
+    m_has_checked_encoding = true;
+    push_sections(start);
+    m_start.clear();
+}
+
+SightRead::Song SightRead::ChartStreamParser::Impl::finish()
+{
+    if (!m_has_checked_encoding) {
+        m_has_checked_encoding = true;
+        push_sections(m_start);
+        m_start.clear();
+    }
+    convert_sections(m_reader.finish());
+    m_converter.finish_song(m_song);
+    return std::move(m_song);
+}
+
+SightRead::ChartStreamParser::ChartStreamParser(
+    const SightRead::Detail::ChartConverter& converter,
+    SightRead::ParseLimits limits)
+    : m_impl {std::make_unique<Impl>(converter, std::move(limits))}
+{
+}
+
+SightRead::ChartStreamParser::ChartStreamParser(
+    SightRead::ChartStreamParser&& other) noexcept
+    = default;
+
+SightRead::ChartStreamParser& SightRead::ChartStreamParser::operator=(
+    SightRead::ChartStreamParser&& other) noexcept
+    = default;
+
+SightRead::ChartStreamParser::~ChartStreamParser() = default;
+
+void SightRead::ChartStreamParser::push(std::string_view data)
+{
+    m_impl->push(data);
+}
+
+SightRead::Song SightRead::ChartStreamParser::finish()
+{
+    return m_impl->finish();
+}
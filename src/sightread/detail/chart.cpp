@@ -1,139 +1,218 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
+
 #include "sightread/detail/chart.hpp"
+#include "sightread/detail/parallel.hpp"
 #include "sightread/detail/stringutil.hpp"
 #include "sightread/songparts.hpp"
 
 namespace {
-std::string_view strip_square_brackets(std::string_view input)
+SightRead::ParseDiagnostic syntax_error(const char* message)
+{
+    return {.category = SightRead::ParseErrorCategory::Syntax,
+            .byte_offset = std::nullopt,
+            .message = message};
+}
+
+std::optional<std::string_view> strip_square_brackets(std::string_view input)
 {
     if (input.empty()) {
-        throw SightRead::ParseError("Header string empty");
+        return std::nullopt;
     }
     return input.substr(1, input.size() - 2);
 }
 
-// Split input by space characters, similar to .Split(' ') in C#. Note that
-// the lifetime of the string_views in the output is the same as that of the
-// input.
-std::vector<std::string_view> split_by_space(std::string_view input)
-{
-    std::vector<std::string_view> substrings;
+constexpr std::size_t MAX_LINE_TOKENS = 5;
 
-    while (true) {
-        const auto space_location = input.find(' ');
-        if (space_location == std::string_view::npos) {
-            break;
+// The first MAX_LINE_TOKENS tokens of a line split by space characters,
+// similar to .Split(' ') in C#. Lines never need more tokens than this, so
+// they are kept in place rather than in a vector to avoid an allocation per
+// line. Note that the lifetime of the string_views is the same as that of the
+// line.
+class LineTokens {
+private:
+    std::string_view m_line;
+    std::array<std::string_view, MAX_LINE_TOKENS> m_tokens;
+    std::size_t m_size {0};
+
+public:
+    explicit LineTokens(std::string_view line)
+        : m_line {line}
+    {
+        while (m_size < MAX_LINE_TOKENS) {
+            const auto space_location = line.find(' ');
+            if (space_location == std::string_view::npos) {
+                m_tokens.at(m_size++) = line;
+                return;
+            }
+            m_tokens.at(m_size++) = line.substr(0, space_location);
+            line.remove_prefix(space_location + 1);
         }
-        substrings.push_back(input.substr(0, space_location));
-        input.remove_prefix(space_location + 1);
     }
 
-    substrings.push_back(input);
-    return substrings;
+    // The number of tokens, capped at MAX_LINE_TOKENS.
+    [[nodiscard]] std::size_t size() const { return m_size; }
+    [[nodiscard]] std::string_view at(std::size_t index) const
+    {
+        return m_tokens.at(index);
+    }
+    // The rest of the line from the start of the token at index onwards.
+    [[nodiscard]] std::string_view rest(std::size_t index) const
+    {
+        return m_line.substr(
+            static_cast<std::size_t>(at(index).data() - m_line.data()));
+    }
+};
+
+std::optional<int> int_token(const LineTokens& tokens, std::size_t index)
+{
+    return SightRead::Detail::string_view_to_int(tokens.at(index));
 }
 
-SightRead::Detail::NoteEvent
-convert_line_to_note(int position,
-                     const std::vector<std::string_view>& split_line)
+SightRead::ParseResult<SightRead::Detail::NoteEvent>
+convert_line_to_note(int position, const LineTokens& tokens)
 {
     constexpr int MAX_NORMAL_EVENT_SIZE = 5;
 
-    if (split_line.size() < MAX_NORMAL_EVENT_SIZE) {
-        throw SightRead::ParseError("Line incomplete");
+    if (tokens.size() < MAX_NORMAL_EVENT_SIZE) {
+        return syntax_error("Line incomplete");
     }
-    const auto fret = SightRead::Detail::string_view_to_int(split_line.at(3));
-    const auto length = SightRead::Detail::string_view_to_int(split_line.at(4));
+    const auto fret = int_token(tokens, 3);
+    const auto length = int_token(tokens, 4);
     if (!fret.has_value() || !length.has_value()) {
-        throw SightRead::ParseError("Bad note event");
+        return syntax_error("Bad note event");
     }
-    return {.position = position, .fret = *fret, .length = *length};
+    return SightRead::Detail::NoteEvent {
+        .position = position, .fret = *fret, .length = *length};
 }
 
-SightRead::Detail::SpecialEvent
-convert_line_to_special(int position,
-                        const std::vector<std::string_view>& split_line)
+SightRead::ParseResult<SightRead::Detail::SpecialEvent>
+convert_line_to_special(int position, const LineTokens& tokens)
 {
     constexpr int MAX_NORMAL_EVENT_SIZE = 5;
 
-    if (split_line.size() < MAX_NORMAL_EVENT_SIZE) {
-        throw SightRead::ParseError("Line incomplete");
+    if (tokens.size() < MAX_NORMAL_EVENT_SIZE) {
+        return syntax_error("Line incomplete");
     }
-    const auto sp_key = SightRead::Detail::string_view_to_int(split_line.at(3));
-    const auto length = SightRead::Detail::string_view_to_int(split_line.at(4));
+    const auto sp_key = int_token(tokens, 3);
+    const auto length = int_token(tokens, 4);
     if (!sp_key.has_value() || !length.has_value()) {
-        throw SightRead::ParseError("Bad SP event");
+        return syntax_error("Bad SP event");
     }
-    return {.position = position, .key = *sp_key, .length = *length};
+    return SightRead::Detail::SpecialEvent {
+        .position = position, .key = *sp_key, .length = *length};
 }
 
-SightRead::Detail::BpmEvent
-convert_line_to_bpm(int position,
-                    const std::vector<std::string_view>& split_line)
+SightRead::ParseResult<SightRead::Detail::BpmEvent>
+convert_line_to_bpm(int position, const LineTokens& tokens)
 {
-    if (split_line.size() < 4) {
-        throw SightRead::ParseError("Line incomplete");
+    if (tokens.size() < 4) {
+        return syntax_error("Line incomplete");
     }
-    const auto bpm = SightRead::Detail::string_view_to_int(split_line.at(3));
+    const auto bpm = int_token(tokens, 3);
     if (!bpm.has_value()) {
-        throw SightRead::ParseError("Bad BPM event");
+        return syntax_error("Bad BPM event");
     }
-    return {.position = position, .bpm = *bpm};
+    return SightRead::Detail::BpmEvent {.position = position, .bpm = *bpm};
 }
 
-SightRead::Detail::TimeSigEvent
-convert_line_to_timesig(int position,
-                        const std::vector<std::string_view>& split_line)
+SightRead::ParseResult<SightRead::Detail::TimeSigEvent>
+convert_line_to_timesig(int position, const LineTokens& tokens)
 {
     constexpr int MAX_NORMAL_EVENT_SIZE = 5;
 
-    if (split_line.size() < 4) {
-        throw SightRead::ParseError("Line incomplete");
+    if (tokens.size() < 4) {
+        return syntax_error("Line incomplete");
     }
-    const auto numer = SightRead::Detail::string_view_to_int(split_line.at(3));
+    const auto numer = int_token(tokens, 3);
     std::optional<int> denom = 2;
-    if (split_line.size() >= MAX_NORMAL_EVENT_SIZE) {
-        denom = SightRead::Detail::string_view_to_int(split_line.at(4));
+    if (tokens.size() >= MAX_NORMAL_EVENT_SIZE) {
+        denom = int_token(tokens, 4);
     }
     if (!numer.has_value() || !denom.has_value()) {
-        throw SightRead::ParseError("Bad TS event");
+        return syntax_error("Bad TS event");
     }
-    return {.position = position, .numerator = *numer, .denominator = *denom};
+    return SightRead::Detail::TimeSigEvent {
+        .position = position, .numerator = *numer, .denominator = *denom};
 }
 
-SightRead::Detail::Event
-convert_line_to_event(int position,
-                      const std::vector<std::string_view>& split_line)
+SightRead::ParseResult<SightRead::Detail::Event>
+convert_line_to_event(int position, const LineTokens& tokens)
 {
-    if (split_line.size() < 4) {
-        throw SightRead::ParseError("Line incomplete");
-    }
-    SightRead::Detail::Event event;
-    event.position = position;
-    for (auto it = std::next(split_line.cbegin(), 3); it < split_line.cend();
-         ++it) {
-        event.data += *it;
-        if (std::next(it) != split_line.cend()) {
-            event.data += ' ';
-        }
+    if (tokens.size() < 4) {
+        return syntax_error("Line incomplete");
     }
-    return event;
+    // Rejoining the remaining tokens with spaces gives back the rest of the
+    // line as it was.
+    return SightRead::Detail::Event {.position = position,
+                                     .data = tokens.rest(3)};
 }
 
-SightRead::Detail::ChartSection read_section(std::string_view& input)
+// Reads the section that starts at the next line of input, which must not be
+// empty. The result is std::nullopt if section_filter rejects the section.
+// Diagnostics give byte offsets from chart_start.
+SightRead::ParseResult<std::optional<SightRead::Detail::ChartSection>>
+read_section(SightRead::Detail::LineReader& input, const char* chart_start,
+             const std::function<bool(std::string_view)>& section_filter)
 {
-    SightRead::Detail::ChartSection section;
-    section.name
-        = strip_square_brackets(SightRead::Detail::break_off_newline(input));
+    std::string_view line = input.next_line();
+    // A section that is cut short is reported at the end of its last line.
+    const auto next_line = [&] {
+        if (input.empty()) {
+            line.remove_prefix(line.size());
+            return false;
+        }
+        line = input.next_line();
+        return true;
+    };
+    const auto error_at_line = [&](SightRead::ParseDiagnostic diagnostic) {
+        diagnostic.byte_offset
+            = static_cast<std::size_t>(line.data() - chart_start);
+        return diagnostic;
+    };
 
-    if (SightRead::Detail::break_off_newline(input) != "{") {
-        throw SightRead::ParseError("Section does not open with {");
+    const auto name = strip_square_brackets(line);
+    if (!name.has_value()) {
+        return error_at_line(syntax_error("Header string empty"));
+    }
+    if (!next_line()) {
+        return error_at_line(syntax_error("No lines left"));
+    }
+    if (line != "{") {
+        return error_at_line(syntax_error("Section does not open with {"));
     }
 
+    if (section_filter && !section_filter(*name)) {
+        do {
+            if (!next_line()) {
+                return error_at_line(syntax_error("No lines left"));
+            }
+        } while (line != "}");
+        return std::optional<SightRead::Detail::ChartSection> {};
+    }
+
+    SightRead::Detail::ChartSection section;
+    section.name = *name;
+    std::optional<SightRead::ParseDiagnostic> diagnostic;
+    const auto add_event = [&](auto& events, auto event) {
+        if (event.has_value()) {
+            events.push_back(*event);
+        } else {
+            diagnostic = std::move(event.error());
+        }
+    };
     while (true) {
-        const auto next_line = SightRead::Detail::break_off_newline(input);
-        if (next_line == "}") {
+        if (!next_line()) {
+            return error_at_line(syntax_error("No lines left"));
+        }
+        if (line == "}") {
             break;
         }
-        const auto separated_line = split_by_space(next_line);
+        const LineTokens separated_line {line};
         if (separated_line.size() < 3) {
             continue;
         }
@@ -143,42 +222,265 @@ SightRead::Detail::ChartSection read_section(std::string_view& input)
             const auto pos = *key_val;
             const auto event_type = separated_line.at(2);
             if (event_type == "N") {
-                section.note_events.push_back(
-                    convert_line_to_note(pos, separated_line));
+                add_event(section.note_events,
+                          convert_line_to_note(pos, separated_line));
             } else if (event_type == "S") {
-                section.special_events.push_back(
-                    convert_line_to_special(pos, separated_line));
+                add_event(section.special_events,
+                          convert_line_to_special(pos, separated_line));
             } else if (event_type == "B") {
-                section.bpm_events.push_back(
-                    convert_line_to_bpm(pos, separated_line));
+                add_event(section.bpm_events,
+                          convert_line_to_bpm(pos, separated_line));
             } else if (event_type == "TS") {
-                section.ts_events.push_back(
-                    convert_line_to_timesig(pos, separated_line));
+                add_event(section.ts_events,
+                          convert_line_to_timesig(pos, separated_line));
             } else if (event_type == "E") {
-                section.events.push_back(
-                    convert_line_to_event(pos, separated_line));
+                add_event(section.events,
+                          convert_line_to_event(pos, separated_line));
+            }
+            if (diagnostic.has_value()) {
+                return error_at_line(std::move(*diagnostic));
             }
         } else {
-            std::string value;
-            for (auto it = std::next(separated_line.cbegin(), 2);
-                 it < separated_line.cend(); ++it) {
-                value.append(*it);
+            // Values are the remaining tokens concatenated, so the spaces
+            // between them are dropped. Only values with spaces need a copy.
+            auto value = separated_line.rest(2);
+            const auto space_count = std::ranges::count(value, ' ');
+            if (space_count > 0) {
+                auto storage = section.arena.allocate(
+                    value.size() - static_cast<std::size_t>(space_count));
+                std::ranges::copy_if(value, storage.begin(),
+                                     [](char c) { return c != ' '; });
+                value = {storage.data(), storage.size()};
             }
-            section.key_value_pairs[std::string(key)] = value;
+            section.key_value_pairs[key] = value;
         }
     }
 
-    return section;
+    return std::optional {std::move(section)};
+}
+
+// Finds the text of each section that satisfies section_filter without
+// tokenising any lines, so sections can be parsed independently. Returns
+// std::nullopt if the chart is malformed, so the error can be reported by
+// parsing it in order.
+std::optional<std::vector<std::string_view>> find_section_texts(
+    std::string_view data,
+    const std::function<bool(std::string_view)>& section_filter)
+{
+    std::vector<std::string_view> section_texts;
+    SightRead::Detail::LineReader reader {data};
+    while (!reader.empty()) {
+        const auto start = reader.position();
+        const auto name = strip_square_brackets(reader.next_line());
+        if (!name.has_value() || reader.empty() || reader.next_line() != "{") {
+            return std::nullopt;
+        }
+        do {
+            if (reader.empty()) {
+                return std::nullopt;
+            }
+        } while (reader.next_line() != "}");
+        if (!section_filter || section_filter(*name)) {
+            section_texts.push_back(
+                data.substr(start, reader.position() - start));
+        }
+    }
+    return section_texts;
 }
 }
 
 SightRead::Detail::Chart SightRead::Detail::parse_chart(std::string_view data)
+{
+    return parse_chart(data, {});
+}
+
+SightRead::Detail::Chart SightRead::Detail::parse_chart(
+    std::string_view data,
+    const std::function<bool(std::string_view)>& section_filter,
+    unsigned int max_threads)
+{
+    return try_parse_chart(data, section_filter, max_threads).value();
+}
+
+SightRead::ParseResult<SightRead::Detail::Chart>
+SightRead::Detail::try_parse_chart(
+    std::string_view data,
+    const std::function<bool(std::string_view)>& section_filter,
+    unsigned int max_threads)
 {
     SightRead::Detail::Chart chart;
 
-    while (!data.empty()) {
-        chart.sections.push_back(read_section(data));
+    std::optional<std::vector<std::string_view>> section_texts;
+    if (thread_count(max_threads) > 1) {
+        section_texts = find_section_texts(data, section_filter);
+    }
+    if (section_texts.has_value()) {
+        auto sections = parallel_map(
+            section_texts->size(), max_threads, [&](std::size_t i) {
+                SightRead::Detail::LineReader reader {(*section_texts)[i]};
+                return read_section(reader, data.data(), {});
+            });
+        for (auto& section : sections) {
+            if (!section.has_value()) {
+                return std::move(section.error());
+            }
+            chart.sections.push_back(std::move(**section));
+        }
+        return chart;
+    }
+
+    SightRead::Detail::LineReader reader {data};
+    while (!reader.empty()) {
+        auto section = read_section(reader, data.data(), section_filter);
+        if (!section.has_value()) {
+            return std::move(section.error());
+        }
+        if (section->has_value()) {
+            chart.sections.push_back(std::move(**section));
+        }
     }
 
     return chart;
 }
+
+std::size_t SightRead::Detail::ChartSection::event_count() const
+{
+    return key_value_pairs.size() + bpm_events.size() + events.size()
+        + note_events.size() + special_events.size() + ts_events.size();
+}
+
+std::span<char> SightRead::Detail::StringArena::allocate(std::size_t size)
+{
+    constexpr std::size_t MIN_BLOCK_SIZE = 256;
+
+    if (m_blocks.empty()
+        || m_blocks.back().capacity() - m_blocks.back().size() < size) {
+        m_blocks.emplace_back().reserve(std::max(size, MIN_BLOCK_SIZE));
+    }
+    // The block has enough capacity, so resizing it does not move its text.
+    auto& block = m_blocks.back();
+    const auto start = block.size();
+    block.resize(start + size);
+    return {std::next(block.begin(), static_cast<std::ptrdiff_t>(start)),
+            block.end()};
+}
+
+SightRead::Detail::ChartSectionReader::ChartSectionReader(
+    std::function<bool(std::string_view)> section_filter)
+    : m_section_filter {std::move(section_filter)}
+{
+}
+
+std::string_view SightRead::Detail::ChartSectionReader::unread_text(
+    std::string_view text) const
+{
+    // parse_chart skips the whitespace after each section along with the
+    // section's final newline.
+    if (m_has_read_section) {
+        return SightRead::Detail::skip_whitespace(text);
+    }
+    return text;
+}
+
+std::string_view
+SightRead::Detail::ChartSectionReader::to_utf8(std::string_view text)
+{
+    if (!m_checks_encoding) {
+        return text;
+    }
+    if (!m_is_latin1) {
+        if (SightRead::Detail::is_valid_utf8(text)) {
+            if (!m_has_read_non_ascii) {
+                m_has_read_non_ascii = !SightRead::Detail::is_ascii(text);
+            }
+            return text;
+        }
+        if (m_has_read_non_ascii) {
+            throw SightRead::ParseError(
+                "Streamed .chart file mixes UTF-8 and Latin-1 text");
+        }
+        m_is_latin1 = true;
+    }
+    if (SightRead::Detail::is_ascii(text)) {
+        return text;
+    }
+    const auto converted = SightRead::Detail::latin1_to_utf8(text);
+    auto storage = m_converted_text.allocate(converted.size());
+    std::ranges::copy(converted, storage.begin());
+    return {storage.data(), storage.size()};
+}
+
+std::vector<SightRead::Detail::ChartSection>
+SightRead::Detail::ChartSectionReader::push(std::string_view data)
+{
+    // The header and opening brace are the first two non-blank lines of a
+    // section, so the first later line that is a lone closing brace ends it.
+    constexpr int HEADER_LINE_COUNT = 2;
+
+    m_converted_text = {};
+    m_buffer.insert(m_buffer.end(), data.cbegin(), data.cend());
+    const std::string_view buffer {m_buffer.data(), m_buffer.size()};
+    std::vector<SightRead::Detail::ChartSection> sections;
+    std::size_t section_start = 0;
+    while (true) {
+        const auto newline_location
+            = SightRead::Detail::find_newline(buffer, m_scan_position);
+        if (newline_location == std::string_view::npos) {
+            break;
+        }
+        auto line = SightRead::Detail::skip_whitespace(buffer.substr(
+            m_scan_position, newline_location - m_scan_position));
+        m_scan_position = newline_location + 1;
+        if (line.empty()) {
+            continue;
+        }
+        ++m_section_line_count;
+        if (line.ends_with('\r')) {
+            line.remove_suffix(1);
+        }
+        if (m_section_line_count <= HEADER_LINE_COUNT || line != "}") {
+            continue;
+        }
+
+        const auto section_text = to_utf8(unread_text(
+            buffer.substr(section_start, m_scan_position - section_start)));
+        SightRead::Detail::LineReader reader {section_text};
+        while (!reader.empty()) {
+            auto section
+                = read_section(reader, section_text.data(), m_section_filter)
+                      .value();
+            if (section.has_value()) {
+                sections.push_back(std::move(*section));
+            }
+        }
+        section_start = m_scan_position;
+        m_section_line_count = 0;
+        m_has_read_section = true;
+    }
+    // The returned sections view the text they were read from, so it is kept
+    // until the next call.
+    if (section_start > 0) {
+        m_read_text = std::move(m_buffer);
+        m_buffer.assign(
+            std::next(m_read_text.cbegin(),
+                      static_cast<std::ptrdiff_t>(section_start)),
+            m_read_text.cend());
+        m_scan_position -= section_start;
+    }
+    return sections;
+}
+
+std::vector<SightRead::Detail::ChartSection>
+SightRead::Detail::ChartSectionReader::finish()
+{
+    m_converted_text = {};
+    m_read_text = std::move(m_buffer);
+    m_buffer.clear();
+    const auto text = to_utf8(unread_text(
+        std::string_view {m_read_text.data(), m_read_text.size()}));
+    auto sections
+        = SightRead::Detail::parse_chart(text, m_section_filter).sections;
+    m_scan_position = 0;
+    m_section_line_count = 0;
+    return sections;
+}
@@ -1,11 +1,16 @@
 #ifndef SIGHTREAD_DETAIL_CHART_HPP
 #define SIGHTREAD_DETAIL_CHART_HPP
 
+#include <cstddef>
+#include <functional>
 #include <map>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "sightread/parseresult.hpp"
+
 namespace SightRead::Detail {
 struct BpmEvent {
     int position;
@@ -14,7 +19,7 @@ struct BpmEvent {
 
 struct Event {
     int position;
-    std::string data;
+    std::string_view data;
 };
 
 struct NoteEvent {
@@ -35,14 +40,41 @@ struct TimeSigEvent {
     int denominator;
 };
 
+// Owns text that could not be kept as a view into the text it came from. Text
+// is stored in blocks that are never reallocated, so views of it stay valid
+// when the arena is moved.
+class StringArena {
+private:
+    std::vector<std::string> m_blocks;
+
+public:
+    StringArena() = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+    ~StringArena() = default;
+
+    // Returns space for size characters that lives as long as the arena.
+    std::span<char> allocate(std::size_t size);
+};
+
+// The name, keys, values, and event text of a section are views into the text
+// it was parsed from where possible, and into its arena otherwise, so that
+// text must outlive the section. Sections are move-only so the views into the
+// arena cannot be separated from it.
 struct ChartSection {
-    std::string name;
-    std::map<std::string, std::string> key_value_pairs;
+    StringArena arena;
+    std::string_view name;
+    std::map<std::string_view, std::string_view> key_value_pairs;
     std::vector<BpmEvent> bpm_events;
     std::vector<Event> events;
     std::vector<NoteEvent> note_events;
     std::vector<SpecialEvent> special_events;
     std::vector<TimeSigEvent> ts_events;
+
+    // The number of lines read into the section's events and key/value pairs.
+    [[nodiscard]] std::size_t event_count() const;
 };
 
 struct Chart {
@@ -50,6 +82,68 @@ struct Chart {
 };
 
 Chart parse_chart(std::string_view data);
+
+// Like parse_chart, but only sections whose name satisfies section_filter are
+// parsed; the lines of other sections are skipped up to their closing brace
+// without being tokenised, and the sections are left out of the result. An
+// empty section_filter keeps every section.
+//
+// With more than one thread (0 means one per hardware thread), section
+// boundaries are found in a pre-pass and the sections are then tokenised on
+// up to max_threads threads, so section_filter is only called from the
+// calling thread. The order of sections in the result is the order in the
+// file regardless of the number of threads.
+Chart parse_chart(std::string_view data,
+                  const std::function<bool(std::string_view)>& section_filter,
+                  unsigned int max_threads = 1);
+
+// Like parse_chart, but returns a diagnostic with the byte offset in data of
+// the offending line instead of throwing if data is malformed.
+SightRead::ParseResult<Chart>
+try_parse_chart(std::string_view data,
+                const std::function<bool(std::string_view)>& section_filter,
+                unsigned int max_threads = 1);
+
+// Reads sections from .chart text that arrives in pieces. Each section is
+// returned by the push call that supplies the newline after its closing brace,
+// and is parsed exactly as parse_chart would parse it. The text the returned
+// sections view is kept until the next call to push or finish.
+//
+// The text is decoded as to_utf8_view decodes a whole file: once any section
+// is not valid UTF-8, it and every later section are read as Latin-1. Throws
+// SightRead::ParseError if an earlier section was read as non-ASCII UTF-8,
+// since that section has already been returned.
+class ChartSectionReader {
+private:
+    std::function<bool(std::string_view)> m_section_filter;
+    // Text is held in vectors rather than strings since moving a vector keeps
+    // its elements where they are, while a short string's text is copied.
+    std::vector<char> m_buffer;
+    std::vector<char> m_read_text;
+    StringArena m_converted_text;
+    std::size_t m_scan_position {0};
+    int m_section_line_count {0};
+    bool m_has_read_section {false};
+    bool m_checks_encoding {true};
+    bool m_is_latin1 {false};
+    bool m_has_read_non_ascii {false};
+
+    [[nodiscard]] std::string_view unread_text(std::string_view text) const;
+    std::string_view to_utf8(std::string_view text);
+
+public:
+    ChartSectionReader() = default;
+    // Sections are filtered as in parse_chart.
+    explicit ChartSectionReader(
+        std::function<bool(std::string_view)> section_filter);
+    // Reads the text as UTF-8 without checking it, as to_utf8_view does for
+    // files with a UTF-8 BOM. Must be called before the first push.
+    void assume_utf8() { m_checks_encoding = false; }
+    std::vector<ChartSection> push(std::string_view data);
+    // Returns the sections left once the input has ended. Throws
+    // SightRead::ParseError if the last section is incomplete.
+    std::vector<ChartSection> finish();
+};
 }
 
 #endif
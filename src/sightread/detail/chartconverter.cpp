@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <charconv>
 #include <climits>
 #include <limits>
 #include <map>
@@ -7,11 +8,13 @@
 #include <utility>
 
 #include "sightread/detail/chartconverter.hpp"
+#include "sightread/detail/parallel.hpp"
 #include "sightread/detail/parserutil.hpp"
 
 namespace {
-std::string get_with_default(const std::map<std::string, std::string>& map,
-                             const std::string& key, std::string default_value)
+std::string_view
+get_with_default(const std::map<std::string_view, std::string_view>& map,
+                 std::string_view key, std::string_view default_value)
 {
     const auto iter = map.find(key);
     if (iter == map.end()) {
@@ -20,6 +23,25 @@ std::string get_with_default(const std::map<std::string, std::string>& map,
     return iter->second;
 }
 
+// Reads the integer at the start of input after any whitespace and plus sign,
+// ignoring whatever follows it, like std::stoi but without throwing.
+std::optional<int> leading_int(std::string_view input)
+{
+    input.remove_prefix(
+        std::min(input.find_first_not_of(" \f\n\r\t\v"), input.size()));
+    if (input.starts_with('+')) {
+        input.remove_prefix(1);
+    }
+    int result = 0;
+    const char* last = input.data() + input.size();
+    // NOLINTNEXTLINE(bugprone-suspicious-stringview-data-usage)
+    const auto [p, ec] = std::from_chars(input.data(), last, result);
+    if (ec != std::errc()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
 SightRead::TempoMap
 tempo_map_from_section(const SightRead::Detail::ChartSection& section,
                        int resolution)
@@ -43,36 +65,119 @@ tempo_map_from_section(const SightRead::Detail::ChartSection& section,
     return {std::move(tses), std::move(bpms), {}, resolution};
 }
 
-std::vector<SightRead::PracticeSection>
-practice_sections_from_section(const SightRead::Detail::ChartSection& section)
+enum class EventKind {
+    Other,
+    PracticeSection,
+    SoloStart,
+    SoloEnd,
+    DiscoFlipStart,
+    DiscoFlipEnd
+};
+
+// Disco flip events are mix_<difficulty>_drums<mode>, optionally in square
+// brackets, where the events that turn the flip on have a trailing d.
+constexpr EventKind classify_mix_event(std::string_view data)
+{
+    using namespace std::string_view_literals;
+
+    constexpr auto DISCO_FLIP_END_SIZE = "mix_*_drums*"sv.size();
+
+    if (data.size() >= 2 && data.front() == '[' && data.back() == ']') {
+        data = data.substr(1, data.size() - 2);
+    }
+    if (data.size() != DISCO_FLIP_END_SIZE
+        && data.size() != DISCO_FLIP_END_SIZE + 1) {
+        return EventKind::Other;
+    }
+    if (!data.starts_with("mix_"sv) || data.substr(5, 6) != "_drums"sv) {
+        return EventKind::Other;
+    }
+    if (data.size() == DISCO_FLIP_END_SIZE) {
+        return EventKind::DiscoFlipEnd;
+    }
+    return data.back() == 'd' ? EventKind::DiscoFlipStart : EventKind::Other;
+}
+
+// Works out what an E event is for from its first character, so each event
+// is compared against at most the few strings that could match it.
+constexpr EventKind classify_event(std::string_view data)
 {
     using namespace std::string_view_literals;
 
-    constexpr std::array practice_section_prefixes {
-        R"("section )"sv, R"("section_)"sv, R"("prc_)"sv};
+    if (data.empty()) {
+        return EventKind::Other;
+    }
+    switch (data.front()) {
+    case '"':
+        if (data.ends_with('"')
+            && (data.starts_with(R"("section )"sv)
+                || data.starts_with(R"("section_)"sv)
+                || data.starts_with(R"("prc_)"sv))) {
+            return EventKind::PracticeSection;
+        }
+        return EventKind::Other;
+    case 's':
+        if (data == "solo"sv) {
+            return EventKind::SoloStart;
+        }
+        if (data == "soloend"sv) {
+            return EventKind::SoloEnd;
+        }
+        return EventKind::Other;
+    case 'm':
+    case '[':
+        return classify_mix_event(data);
+    default:
+        return EventKind::Other;
+    }
+}
+
+// The positions of the events of each kind in a section, gathered in one pass
+// over its events.
+struct SectionEvents {
     std::vector<SightRead::PracticeSection> practice_sections;
+    std::vector<int> solo_on_events;
+    std::vector<int> solo_off_events;
+    std::vector<int> disco_flip_on_events;
+    std::vector<int> disco_flip_off_events;
+};
+
+SectionEvents
+classify_section_events(const SightRead::Detail::ChartSection& section)
+{
+    SectionEvents events;
     for (const auto& event : section.events) {
-        std::string_view section_name = event.data;
-        if (!section_name.ends_with('"')) {
-            continue;
-        }
-        section_name = section_name.substr(0, section_name.size() - 1);
-        for (auto prefix : practice_section_prefixes) {
-            if (!section_name.starts_with(prefix)) {
-                continue;
-            }
-            section_name = section_name.substr(prefix.size());
-            practice_sections.push_back(
-                {.name = std::string {section_name},
+        switch (classify_event(event.data)) {
+        case EventKind::PracticeSection: {
+            // The name starts after the prefix's first underscore or space.
+            const auto name_start = event.data.find_first_of("_ ") + 1;
+            events.practice_sections.push_back(
+                {.name = std::string {event.data.substr(
+                     name_start, event.data.size() - name_start - 1)},
                  .start = SightRead::Tick {event.position}});
             break;
         }
+        case EventKind::SoloStart:
+            events.solo_on_events.push_back(event.position);
+            break;
+        case EventKind::SoloEnd:
+            events.solo_off_events.push_back(event.position);
+            break;
+        case EventKind::DiscoFlipStart:
+            events.disco_flip_on_events.push_back(event.position);
+            break;
+        case EventKind::DiscoFlipEnd:
+            events.disco_flip_off_events.push_back(event.position);
+            break;
+        case EventKind::Other:
+            break;
+        }
     }
-    return practice_sections;
+    return events;
 }
 
 std::optional<std::tuple<SightRead::Difficulty, SightRead::Instrument>>
-diff_inst_from_header(const std::string& header)
+diff_inst_from_header(std::string_view header)
 {
     using namespace std::literals;
 
@@ -213,7 +318,8 @@ std::vector<SightRead::Note> add_fifth_lane_greens(
 }
 
 std::vector<SightRead::Note>
-apply_cymbal_events(const std::vector<SightRead::Note>& notes)
+apply_cymbal_events(const std::vector<SightRead::Note>& notes,
+                    const SightRead::Detail::LimitChecker& limit_checker)
 {
     std::map<unsigned int,
              std::vector<std::tuple<SightRead::Tick, SightRead::Tick>>>
@@ -230,11 +336,14 @@ apply_cymbal_events(const std::vector<SightRead::Note>& notes)
         }
     }
 
+    // Each note is checked against every marker in its lanes, so the time
+    // budget is checked note by note.
     std::vector<SightRead::Note> new_notes;
     for (auto note : notes) {
         if ((note.flags & SightRead::FLAGS_CYMBAL) != 0U) {
             continue;
         }
+        SightRead::Detail::throw_on_exceeded_limit(limit_checker.check_time());
         for (auto i = 0U; i < note.lengths.size(); ++i) {
             if (note.lengths.at(i) == SightRead::Tick {-1}) {
                 continue;
@@ -381,59 +490,24 @@ public:
 std::vector<SightRead::Note>
 apply_drum_events(std::vector<SightRead::Note> notes,
                   const std::vector<SightRead::Detail::NoteEvent>& note_events,
-                  SightRead::TrackType track_type)
+                  SightRead::TrackType track_type,
+                  const SightRead::Detail::LimitChecker& limit_checker)
 {
     if (track_type != SightRead::TrackType::Drums) {
         return notes;
     }
     notes = add_fifth_lane_greens(std::move(notes), note_events);
-    notes = apply_cymbal_events(notes);
+    notes = apply_cymbal_events(notes, limit_checker);
     return apply_dynamics_events(notes, note_events);
 }
 
-bool matches_template(const std::string& data, std::string_view str_template)
-{
-    if (data.size() < 2) {
-        return false;
-    }
-
-    auto begin = data.cbegin();
-    auto end = data.cend();
-
-    if (*begin == '[' && *std::prev(end) == ']') {
-        ++begin;
-        --end;
-    }
-
-    if (std::distance(begin, end) != static_cast<int>(str_template.size())) {
-        return false;
-    }
-
-    for (auto i = 0U; i < str_template.size(); ++i) {
-        if (str_template.at(i) != '*' && str_template.at(i) != *(begin + i)) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-bool is_event_disco_start(const std::string& data)
-{
-    return matches_template(data, "mix_*_drums*d");
-}
-
-bool is_event_disco_end(const std::string& data)
-{
-    return matches_template(data, "mix_*_drums*");
-}
-
 SightRead::NoteTrack
 note_track_from_section(const SightRead::Detail::ChartSection& section,
                         std::shared_ptr<SightRead::SongGlobalData> global_data,
                         SightRead::TrackType track_type,
                         SightRead::SoloParsingBehaviour solo_parsing_behaviour,
-                        bool allow_open_chords, SightRead::Tick max_hopo_gap)
+                        bool allow_open_chords, SightRead::Tick max_hopo_gap,
+                        const SightRead::Detail::LimitChecker& limit_checker)
 {
     constexpr int DRUM_FILL_KEY = 64;
 
@@ -450,7 +524,8 @@ note_track_from_section(const SightRead::Detail::ChartSection& section,
         }
     }
     forcing_events.apply_forcing(notes);
-    notes = apply_drum_events(notes, section.note_events, track_type);
+    notes = apply_drum_events(notes, section.note_events, track_type,
+                              limit_checker);
 
     std::vector<SightRead::DrumFill> fills;
     std::vector<SightRead::StarPower> sp;
@@ -470,32 +545,19 @@ note_track_from_section(const SightRead::Detail::ChartSection& section,
         fills.shrink_to_fit();
     }
 
-    std::vector<int> solo_on_events;
-    std::vector<int> solo_off_events;
-    std::vector<int> disco_flip_on_events;
-    std::vector<int> disco_flip_off_events;
-    for (const auto& event : section.events) {
-        if (event.data == "solo") {
-            solo_on_events.push_back(event.position);
-        } else if (event.data == "soloend") {
-            solo_off_events.push_back(event.position);
-        } else if (is_event_disco_start(event.data)) {
-            disco_flip_on_events.push_back(event.position);
-        } else if (is_event_disco_end(event.data)) {
-            disco_flip_off_events.push_back(event.position);
-        }
-    }
-    std::ranges::sort(solo_on_events);
-    std::ranges::sort(solo_off_events);
+    auto events = classify_section_events(section);
+    std::ranges::sort(events.solo_on_events);
+    std::ranges::sort(events.solo_off_events);
     auto solos = SightRead::Detail::form_solo_vector(
-        solo_on_events, solo_off_events, notes, track_type,
-        solo_parsing_behaviour, false);
-    std::ranges::sort(disco_flip_on_events);
-    std::ranges::sort(disco_flip_off_events);
-    disco_flip_off_events.push_back(std::numeric_limits<int>::max());
+        events.solo_on_events, events.solo_off_events, notes, track_type,
+        solo_parsing_behaviour, false, limit_checker)
+                     .value();
+    std::ranges::sort(events.disco_flip_on_events);
+    std::ranges::sort(events.disco_flip_off_events);
+    events.disco_flip_off_events.push_back(std::numeric_limits<int>::max());
     std::vector<SightRead::DiscoFlip> disco_flips;
     for (auto [start, end] : SightRead::Detail::combine_solo_events(
-             disco_flip_on_events, disco_flip_off_events,
+             events.disco_flip_on_events, events.disco_flip_off_events,
              SightRead::SoloParsingBehaviour::PreferEarlierStarts)) {
         disco_flips.push_back({.position = start, .length = end - start});
     }
@@ -551,6 +613,8 @@ SightRead::Detail::ChartConverter::ChartConverter(SightRead::Metadata metadata)
     , m_solo_parsing_behaviour {SightRead::SoloParsingBehaviour::
                                     PreferLaterStarts}
     , m_allow_open_chords {true}
+    , m_max_threads {1}
+    , m_limit_checker {SightRead::ParseLimits {}}
 {
 }
 
@@ -577,8 +641,129 @@ SightRead::Detail::ChartConverter::allow_open_chords(bool allow_open_chords)
     return *this;
 }
 
+SightRead::Detail::ChartConverter&
+SightRead::Detail::ChartConverter::max_threads(unsigned int max_threads)
+{
+    m_max_threads = max_threads;
+    return *this;
+}
+
+SightRead::Detail::ChartConverter&
+SightRead::Detail::ChartConverter::limit_checker(
+    const SightRead::Detail::LimitChecker& limit_checker)
+{
+    m_limit_checker = limit_checker;
+    return *this;
+}
+
+std::optional<std::tuple<SightRead::Difficulty, SightRead::Instrument>>
+SightRead::Detail::ChartConverter::permitted_track(
+    std::string_view section_name) const
+{
+    const auto pair = diff_inst_from_header(section_name);
+    if (!pair.has_value()
+        || !m_permitted_instruments.contains(std::get<1>(*pair))) {
+        return std::nullopt;
+    }
+    return pair;
+}
+
+SightRead::NoteTrack SightRead::Detail::ChartConverter::note_track(
+    const SightRead::Detail::ChartSection& section,
+    SightRead::Instrument instrument,
+    const std::shared_ptr<SightRead::SongGlobalData>& global_data) const
+{
+    SightRead::Detail::throw_on_exceeded_limit(m_limit_checker.check_time());
+    const auto resolution = global_data->resolution();
+    return note_track_from_section(
+        section, global_data, track_type_from_instrument(instrument),
+        m_solo_parsing_behaviour, m_allow_open_chords,
+        m_hopo_threshold.chart_max_hopo_gap(resolution), m_limit_checker);
+}
+
 SightRead::Song SightRead::Detail::ChartConverter::convert(
     const SightRead::Detail::Chart& chart) const
+{
+    auto song = convert_sections(chart);
+    finish_song(song);
+    return song;
+}
+
+SightRead::ParseResult<SightRead::Song>
+SightRead::Detail::ChartConverter::try_convert(
+    const SightRead::Detail::Chart& chart) const
+{
+    const auto content_error = [](std::string message) {
+        return SightRead::ParseDiagnostic {
+            .category = SightRead::ParseErrorCategory::Content,
+            .byte_offset = std::nullopt,
+            .message = std::move(message)};
+    };
+
+    // Only invalid tempo maps and exceeded time budgets throw here, so this is
+    // not on the hot path.
+    std::optional<SightRead::Song> song;
+    try {
+        song = convert_sections(chart);
+    } catch (const SightRead::ParseLimitError& e) {
+        return SightRead::ParseDiagnostic {
+            .category = SightRead::ParseErrorCategory::LimitExceeded,
+            .byte_offset = std::nullopt,
+            .message = e.what()};
+    } catch (const SightRead::ParseError& e) {
+        return content_error(e.what());
+    }
+    if (song->instruments().empty()) {
+        return content_error("Chart has no notes");
+    }
+    return std::move(*song);
+}
+
+SightRead::Song SightRead::Detail::ChartConverter::convert_sections(
+    const SightRead::Detail::Chart& chart) const
+{
+    auto song = new_song();
+
+    // Building a note track only reads the song's resolution, which only Song
+    // sections change. Sections up to the last Song section are converted in
+    // order; after that the instrument sections are independent and may be
+    // converted in parallel, and are added to the song in the same order
+    // either way.
+    std::size_t independent_start = 0;
+    for (auto i = 0U; i < chart.sections.size(); ++i) {
+        if (chart.sections[i].name == "Song") {
+            independent_start = i + 1;
+        }
+    }
+    std::vector<std::tuple<SightRead::Difficulty, SightRead::Instrument,
+                           const SightRead::Detail::ChartSection*>>
+        instrument_sections;
+    for (auto i = 0U; i < chart.sections.size(); ++i) {
+        const auto& section = chart.sections[i];
+        const auto track = permitted_track(section.name);
+        if (i < independent_start || !track.has_value()) {
+            convert_section(song, section);
+        } else {
+            const auto [diff, inst] = *track;
+            instrument_sections.emplace_back(diff, inst, &section);
+        }
+    }
+
+    const auto& global_data = song.global_data_ptr();
+    auto note_tracks = parallel_map(
+        instrument_sections.size(), m_max_threads, [&](std::size_t i) {
+            const auto& [diff, inst, section] = instrument_sections[i];
+            return note_track(*section, inst, global_data);
+        });
+    for (auto i = 0U; i < instrument_sections.size(); ++i) {
+        const auto& [diff, inst, section] = instrument_sections[i];
+        song.add_note_track(inst, diff, std::move(note_tracks[i]));
+    }
+
+    return song;
+}
+
+SightRead::Song SightRead::Detail::ChartConverter::new_song() const
 {
     SightRead::Song song;
 
@@ -587,45 +772,50 @@ SightRead::Song SightRead::Detail::ChartConverter::convert(
     song.global_data().artist(m_artist);
     song.global_data().charter(m_charter);
 
-    for (const auto& section : chart.sections) {
-        if (section.name == "Song") {
-            try {
-                const auto resolution = std::stoi(get_with_default(
-                    section.key_value_pairs, "Resolution", "192"));
-                song.global_data().resolution(resolution);
-            } catch (const std::invalid_argument&) { // NOLINT
-                // CH just ignores this kind of parsing mistake.
-                // TODO: Use from_chars instead to avoid having to use
-                // exceptions as control flow.
-            }
-        } else if (section.name == "SyncTrack") {
-            song.global_data().tempo_map(tempo_map_from_section(
-                section, song.global_data().resolution()));
-        } else if (section.name == "Events") {
-            song.global_data().practice_sections(
-                practice_sections_from_section(section));
-        } else {
-            auto pair = diff_inst_from_header(section.name);
-            if (!pair.has_value()) {
-                continue;
-            }
-            auto [diff, inst] = *pair;
-            if (!m_permitted_instruments.contains(inst)) {
-                continue;
-            }
-            const auto resolution = song.global_data().resolution();
-            auto note_track = note_track_from_section(
-                section, song.global_data_ptr(),
-                track_type_from_instrument(inst), m_solo_parsing_behaviour,
-                m_allow_open_chords,
-                m_hopo_threshold.chart_max_hopo_gap(resolution));
-            song.add_note_track(inst, diff, std::move(note_track));
+    return song;
+}
+
+void SightRead::Detail::ChartConverter::convert_section(
+    SightRead::Song& song, const SightRead::Detail::ChartSection& section) const
+{
+    if (section.name == "Song") {
+        const auto resolution = leading_int(
+            get_with_default(section.key_value_pairs, "Resolution", "192"));
+        // CH just ignores this kind of parsing mistake.
+        if (resolution.has_value()) {
+            song.global_data().resolution(*resolution);
         }
+    } else if (section.name == "SyncTrack") {
+        song.global_data().tempo_map(tempo_map_from_section(
+            section, song.global_data().resolution()));
+    } else if (section.name == "Events") {
+        song.global_data().practice_sections(
+            classify_section_events(section).practice_sections);
+    } else {
+        const auto track = permitted_track(section.name);
+        if (!track.has_value()) {
+            return;
+        }
+        const auto [diff, inst] = *track;
+        song.add_note_track(
+            inst, diff, note_track(section, inst, song.global_data_ptr()));
     }
+}
 
+void SightRead::Detail::ChartConverter::finish_song(
+    const SightRead::Song& song) const
+{
     if (song.instruments().empty()) {
         throw SightRead::ParseError("Chart has no notes");
     }
+}
 
-    return song;
+bool SightRead::Detail::ChartConverter::is_section_used(
+    std::string_view section_name) const
+{
+    if (section_name == "Song" || section_name == "SyncTrack"
+        || section_name == "Events") {
+        return true;
+    }
+    return permitted_track(section_name).has_value();
 }
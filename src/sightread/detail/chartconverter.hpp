@@ -1,11 +1,17 @@
 #ifndef SIGHTREAD_DETAIL_CHARTCONVERTER_HPP
 #define SIGHTREAD_DETAIL_CHARTCONVERTER_HPP
 
+#include <memory>
+#include <optional>
 #include <set>
 #include <string>
+#include <string_view>
+#include <tuple>
 
 #include "sightread/detail/chart.hpp"
+#include "sightread/detail/limitchecker.hpp"
 #include "sightread/metadata.hpp"
+#include "sightread/parseresult.hpp"
 #include "sightread/soloparsingbehaviour.hpp"
 #include "sightread/song.hpp"
 #include "sightread/songparts.hpp"
@@ -20,6 +26,20 @@ private:
     std::set<SightRead::Instrument> m_permitted_instruments;
     SightRead::SoloParsingBehaviour m_solo_parsing_behaviour;
     bool m_allow_open_chords;
+    unsigned int m_max_threads;
+    SightRead::Detail::LimitChecker m_limit_checker;
+
+    [[nodiscard]] std::optional<
+        std::tuple<SightRead::Difficulty, SightRead::Instrument>>
+    permitted_track(std::string_view section_name) const;
+    [[nodiscard]] SightRead::NoteTrack
+    note_track(const SightRead::Detail::ChartSection& section,
+               SightRead::Instrument instrument,
+               const std::shared_ptr<SightRead::SongGlobalData>& global_data)
+        const;
+    // convert without the check that the song has notes.
+    [[nodiscard]] SightRead::Song
+    convert_sections(const SightRead::Detail::Chart& chart) const;
 
 public:
     explicit ChartConverter(SightRead::Metadata metadata);
@@ -28,8 +48,31 @@ public:
     ChartConverter&
     solo_parsing_behaviour(SightRead::SoloParsingBehaviour behaviour);
     ChartConverter& allow_open_chords(bool allow_open_chords);
+    // Sets the number of threads instrument sections may be converted on by
+    // convert, where 0 means one per hardware thread.
+    ChartConverter& max_threads(unsigned int max_threads);
+    // Sets the checker whose time budget conversion is held to. Converting
+    // throws SightRead::ParseLimitError once the budget runs out, including
+    // partway through a track. By default there is no budget.
+    ChartConverter&
+    limit_checker(const SightRead::Detail::LimitChecker& limit_checker);
     [[nodiscard]] SightRead::Song
     convert(const SightRead::Detail::Chart& chart) const;
+    // Like convert, but returns a diagnostic instead of throwing if the chart
+    // does not describe a usable song.
+    [[nodiscard]] SightRead::ParseResult<SightRead::Song>
+    try_convert(const SightRead::Detail::Chart& chart) const;
+    // convert is equivalent to calling convert_section on the song from
+    // new_song for each section in order, then calling finish_song. Sections
+    // only depend on those before them, so they can be converted as they are
+    // read.
+    [[nodiscard]] SightRead::Song new_song() const;
+    void convert_section(SightRead::Song& song,
+                         const SightRead::Detail::ChartSection& section) const;
+    void finish_song(const SightRead::Song& song) const;
+    // Whether a section with this name can contribute to the converted song.
+    // Sections for which this is false can be skipped when parsing.
+    [[nodiscard]] bool is_section_used(std::string_view section_name) const;
 };
 }
 
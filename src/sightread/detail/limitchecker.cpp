@@ -0,0 +1,74 @@
+#include <utility>
+
+#include "sightread/detail/limitchecker.hpp"
+
+namespace {
+std::optional<SightRead::ParseDiagnostic>
+check_count(std::size_t count, std::optional<std::size_t> limit,
+            const char* message)
+{
+    if (!limit.has_value() || count <= *limit) {
+        return std::nullopt;
+    }
+    return SightRead::ParseDiagnostic {
+        .category = SightRead::ParseErrorCategory::LimitExceeded,
+        .byte_offset = std::nullopt,
+        .message = message};
+}
+}
+
+SightRead::Detail::LimitChecker::LimitChecker(SightRead::ParseLimits limits)
+    : m_limits {std::move(limits)}
+    , m_start {std::chrono::steady_clock::now()}
+{
+}
+
+std::optional<SightRead::ParseDiagnostic>
+SightRead::Detail::LimitChecker::check_payload(std::size_t byte_count) const
+{
+    return check_count(byte_count, m_limits.max_payload_bytes,
+                       "File exceeds the payload byte limit");
+}
+
+std::optional<SightRead::ParseDiagnostic>
+SightRead::Detail::LimitChecker::check_sections(std::size_t section_count) const
+{
+    return check_count(section_count, m_limits.max_sections,
+                       "File exceeds the section limit");
+}
+
+std::optional<SightRead::ParseDiagnostic>
+SightRead::Detail::LimitChecker::check_tracks(std::size_t track_count) const
+{
+    return check_count(track_count, m_limits.max_tracks,
+                       "File exceeds the track limit");
+}
+
+std::optional<SightRead::ParseDiagnostic>
+SightRead::Detail::LimitChecker::check_events(std::size_t event_count) const
+{
+    return check_count(event_count, m_limits.max_events,
+                       "File exceeds the event limit");
+}
+
+std::optional<SightRead::ParseDiagnostic>
+SightRead::Detail::LimitChecker::check_time() const
+{
+    if (!m_limits.time_budget.has_value()
+        || std::chrono::steady_clock::now() - m_start
+            <= *m_limits.time_budget) {
+        return std::nullopt;
+    }
+    return SightRead::ParseDiagnostic {
+        .category = SightRead::ParseErrorCategory::LimitExceeded,
+        .byte_offset = std::nullopt,
+        .message = "Parsing exceeded its time budget"};
+}
+
+void SightRead::Detail::throw_on_exceeded_limit(
+    const std::optional<SightRead::ParseDiagnostic>& diagnostic)
+{
+    if (diagnostic.has_value()) {
+        throw SightRead::ParseLimitError(diagnostic->message);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef SIGHTREAD_DETAIL_LIMITCHECKER_HPP
+#define SIGHTREAD_DETAIL_LIMITCHECKER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+#include "sightread/parselimits.hpp"
+#include "sightread/parseresult.hpp"
+
+namespace SightRead::Detail {
+// Checks the stages of one parse against a ParseLimits. Each check returns a
+// LimitExceeded diagnostic if its limit is exceeded. The time budget runs from
+// when the checker is constructed.
+class LimitChecker {
+private:
+    SightRead::ParseLimits m_limits;
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    explicit LimitChecker(SightRead::ParseLimits limits);
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic>
+    check_payload(std::size_t byte_count) const;
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic>
+    check_sections(std::size_t section_count) const;
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic>
+    check_tracks(std::size_t track_count) const;
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic>
+    check_events(std::size_t event_count) const;
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic> check_time() const;
+};
+
+// Throws SightRead::ParseLimitError if there is a diagnostic.
+void throw_on_exceeded_limit(
+    const std::optional<SightRead::ParseDiagnostic>& diagnostic);
+}
+
+#endif
@@ -0,0 +1,177 @@
+#include <cerrno>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "sightread/detail/mappedfile.hpp"
+
+namespace {
+[[noreturn]] void throw_not_regular_file(const std::filesystem::path& path)
+{
+    throw std::filesystem::filesystem_error(
+        "Not a regular file", path,
+        std::make_error_code(std::errc::invalid_argument));
+}
+
+#ifdef _WIN32
+[[noreturn]] void throw_mapping_error(const std::filesystem::path& path)
+{
+    throw std::filesystem::filesystem_error(
+        "Failed to map file", path,
+        std::error_code(static_cast<int>(GetLastError()),
+                        std::system_category()));
+}
+
+// Closes a Windows handle when it goes out of scope.
+class HandleCloser {
+private:
+    HANDLE m_handle;
+
+public:
+    explicit HandleCloser(HANDLE handle)
+        : m_handle {handle}
+    {
+    }
+    ~HandleCloser() { CloseHandle(m_handle); }
+    HandleCloser(const HandleCloser&) = delete;
+    HandleCloser& operator=(const HandleCloser&) = delete;
+    HandleCloser(HandleCloser&&) = delete;
+    HandleCloser& operator=(HandleCloser&&) = delete;
+};
+#else
+[[noreturn]] void throw_mapping_error(const std::filesystem::path& path)
+{
+    throw std::filesystem::filesystem_error(
+        "Failed to map file", path,
+        std::error_code(errno, std::generic_category()));
+}
+
+// Closes a file descriptor when it goes out of scope.
+class FileDescriptorCloser {
+private:
+    int m_fd;
+
+public:
+    explicit FileDescriptorCloser(int fd)
+        : m_fd {fd}
+    {
+    }
+    ~FileDescriptorCloser() { close(m_fd); }
+    FileDescriptorCloser(const FileDescriptorCloser&) = delete;
+    FileDescriptorCloser& operator=(const FileDescriptorCloser&) = delete;
+    FileDescriptorCloser(FileDescriptorCloser&&) = delete;
+    FileDescriptorCloser& operator=(FileDescriptorCloser&&) = delete;
+};
+#endif
+}
+
+#ifdef _WIN32
+SightRead::Detail::MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    const auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                  nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-cstyle-cast)
+    if (file == INVALID_HANDLE_VALUE) {
+        throw_mapping_error(path);
+    }
+    const HandleCloser file_closer {file};
+    // Pipes and character devices have no size to map.
+    if (GetFileType(file) != FILE_TYPE_DISK) {
+        throw_not_regular_file(path);
+    }
+
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) == 0) {
+        throw_mapping_error(path);
+    }
+    m_size = static_cast<std::size_t>(file_size.QuadPart);
+    // Empty files cannot be mapped, but there is nothing to map anyway.
+    if (m_size == 0) {
+        return;
+    }
+
+    const auto mapping
+        = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        throw_mapping_error(path);
+    }
+    // The view keeps the mapping alive after its handle is closed.
+    const HandleCloser mapping_closer {mapping};
+
+    const auto* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        throw_mapping_error(path);
+    }
+    m_data = static_cast<const std::uint8_t*>(view);
+}
+
+SightRead::Detail::MappedFile::~MappedFile()
+{
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+}
+#else
+SightRead::Detail::MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    // O_NONBLOCK stops opening a FIFO from waiting for a writer. It has no
+    // effect on reads from regular files.
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    const auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd == -1) {
+        throw_mapping_error(path);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    const FileDescriptorCloser fd_closer {fd};
+
+    struct stat file_status {};
+    if (fstat(fd, &file_status) == -1) {
+        throw_mapping_error(path);
+    }
+    // FIFOs and devices report a size of 0, so would otherwise map as empty.
+    if (!S_ISREG(file_status.st_mode)) {
+        throw_not_regular_file(path);
+    }
+    m_size = static_cast<std::size_t>(file_status.st_size);
+    // Empty files cannot be mapped, but there is nothing to map anyway.
+    if (m_size == 0) {
+        return;
+    }
+
+    auto* view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        throw_mapping_error(path);
+    }
+    // Parsers read files front to back.
+    posix_madvise(view, m_size, POSIX_MADV_SEQUENTIAL);
+    m_data = static_cast<const std::uint8_t*>(view);
+}
+
+SightRead::Detail::MappedFile::~MappedFile()
+{
+    if (m_data != nullptr) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+        munmap(const_cast<std::uint8_t*>(m_data), m_size);
+    }
+}
+#endif
+
+std::string_view SightRead::Detail::MappedFile::chars() const
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<const char*>(m_data), m_size};
+}
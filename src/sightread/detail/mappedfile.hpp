@@ -0,0 +1,41 @@
+#ifndef SIGHTREAD_DETAIL_MAPPEDFILE_HPP
+#define SIGHTREAD_DETAIL_MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+namespace SightRead::Detail {
+// A read-only memory mapping of a whole file. The contents are read straight
+// from the page cache, so no copy of the file is made. Throws
+// std::filesystem::filesystem_error if the file cannot be opened or mapped, or
+// is not a regular file.
+//
+// The mapping is not a snapshot. On POSIX systems, if another process
+// truncates the file while it is mapped, reading the pages past the new end
+// raises SIGBUS rather than an exception. Windows refuses to truncate a file
+// while it is mapped.
+class MappedFile {
+private:
+    const std::uint8_t* m_data {nullptr};
+    std::size_t m_size {0};
+
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    [[nodiscard]] std::span<const std::uint8_t> bytes() const
+    {
+        return {m_data, m_size};
+    }
+    [[nodiscard]] std::string_view chars() const;
+};
+}
+
+#endif
@@ -1,5 +1,8 @@
+#include <optional>
+#include <string>
 #include <utility>
 
+#include "sightread/detail/parallel.hpp"
 #include "sightread/detail/utils.hpp"
 #include "sightread/songparts.hpp"
 
@@ -11,7 +14,16 @@ struct MidiHeader {
     int num_of_tracks;
 };
 
-MidiHeader read_midi_header(std::span<const std::uint8_t>& data)
+SightRead::ParseDiagnostic syntax_error(std::size_t byte_offset,
+                                        std::string message)
+{
+    return {.category = SightRead::ParseErrorCategory::Syntax,
+            .byte_offset = byte_offset,
+            .message = std::move(message)};
+}
+
+SightRead::ParseResult<MidiHeader>
+read_midi_header(std::span<const std::uint8_t>& data)
 {
     constexpr std::array<std::uint8_t, 10> MAGIC_NUMBER {
         0x4D, 0x54, 0x68, 0x64, 0, 0, 0, 6, 0, 1};
@@ -21,65 +33,86 @@ MidiHeader read_midi_header(std::span<const std::uint8_t>& data)
     constexpr int TRACK_COUNT_OFFSET = 10;
 
     if (data.size() < FIRST_TRACK_OFFSET) {
-        throw_on_insufficient_bytes();
+        return syntax_error(0, "insufficient bytes");
     }
 
     const auto first_ten_bytes = data.subspan(0, MAGIC_NUMBER.size());
     if (!std::equal(first_ten_bytes.begin(), first_ten_bytes.end(),
                     MAGIC_NUMBER.cbegin())) {
-        throw SightRead::ParseError("Invalid MIDI file");
+        return syntax_error(0, "Invalid MIDI file");
     }
     const auto num_of_tracks
         = read_two_byte_be<std::int16_t>(data, TRACK_COUNT_OFFSET);
     const auto division = read_two_byte_be<std::int16_t>(data, TICKS_OFFSET);
     if ((division & DIVISION_NEGATIVE_SMPTE_MASK) != 0) {
-        throw SightRead::ParseError("Only ticks per quarter-note is supported");
+        return syntax_error(TICKS_OFFSET,
+                            "Only ticks per quarter-note is supported");
     }
     data = data.subspan(FIRST_TRACK_OFFSET);
-    return {.ticks_per_quarter_note = division, .num_of_tracks = num_of_tracks};
+    return MidiHeader {.ticks_per_quarter_note = division,
+                       .num_of_tracks = num_of_tracks};
 }
 
-int read_variable_length_num(std::span<const std::uint8_t>& data)
+// The unread part of a track chunk. end_offset is the position in the file of
+// the end of the chunk, so diagnostics can give the position of a problem.
+struct ChunkReader {
+    std::span<const std::uint8_t> data;
+    std::size_t end_offset;
+
+    [[nodiscard]] std::size_t offset() const
+    {
+        return end_offset - data.size();
+    }
+};
+
+SightRead::ParseResult<int> read_variable_length_num(ChunkReader& reader)
 {
     constexpr int VARIABLE_LENGTH_DATA_MASK = 0x7F;
     constexpr int VARIABLE_LENGTH_DATA_SIZE = 7;
     constexpr int VARIABLE_LENGTH_HIGH_MASK = 0x80;
 
+    auto& data = reader.data;
     int number = 0;
     int bytes_read = 0;
     while (!data.empty() && ((data.front() & VARIABLE_LENGTH_HIGH_MASK) != 0)) {
         ++bytes_read;
         if (bytes_read >= 4) {
-            throw SightRead::ParseError("Too long variable length number");
+            return syntax_error(reader.offset(),
+                                "Too long variable length number");
         }
         number <<= VARIABLE_LENGTH_DATA_SIZE;
         number |= pop_front(data) & VARIABLE_LENGTH_DATA_MASK;
     }
+    if (data.empty()) {
+        return insufficient_bytes(reader.offset());
+    }
     number <<= VARIABLE_LENGTH_DATA_SIZE;
     number |= pop_front(data) & VARIABLE_LENGTH_DATA_MASK;
     return number;
 }
 
-SightRead::Detail::MetaEvent
-read_meta_event(std::span<const std::uint8_t>& data)
+SightRead::ParseResult<SightRead::Detail::MetaEvent>
+read_meta_event(ChunkReader& reader)
 {
-    if (data.empty()) {
-        throw_on_insufficient_bytes();
+    if (reader.data.empty()) {
+        return insufficient_bytes(reader.offset());
     }
     SightRead::Detail::MetaEvent event;
-    event.type = pop_front(data);
-    const auto data_length = read_variable_length_num(data);
-    if (static_cast<std::size_t>(data_length) > data.size()) {
-        throw SightRead::ParseError("Meta Event too long");
-    }
-    event.data
-        = std::vector<std::uint8_t> {data.begin(), data.begin() + data_length};
-    data = data.subspan(static_cast<std::size_t>(data_length));
+    event.type = pop_front(reader.data);
+    const auto data_length = read_variable_length_num(reader);
+    if (!data_length) {
+        return data_length.error();
+    }
+    if (static_cast<std::size_t>(*data_length) > reader.data.size()) {
+        return syntax_error(reader.offset(), "Meta Event too long");
+    }
+    event.data = reader.data.first(static_cast<std::size_t>(*data_length));
+    reader.data = reader.data.subspan(event.data.size());
     return event;
 }
 
-SightRead::Detail::MidiEvent
-read_midi_event(std::span<const std::uint8_t>& data, int prev_status_byte)
+SightRead::ParseResult<SightRead::Detail::MidiEvent>
+read_midi_event(ChunkReader& reader, int prev_status_byte)
 {
     constexpr int CHANNEL_PRESSURE_ID = 0xD0;
     constexpr int IS_STATUS_BYTE_MASK = 0x80;
@@ -87,8 +120,9 @@ read_midi_event(std::span<const std::uint8_t>& data, int prev_status_byte)
     constexpr int SYSTEM_COMMON_MSG_ID = 0xF0;
     constexpr int UPPER_NIBBLE_MASK = 0xF0;
 
+    auto& data = reader.data;
     if (data.empty()) {
-        throw_on_insufficient_bytes();
+        return insufficient_bytes(reader.offset());
     }
     auto event_type = data.front();
     if ((event_type & IS_STATUS_BYTE_MASK) != 0) {
@@ -96,90 +130,262 @@ read_midi_event(std::span<const std::uint8_t>& data, int prev_status_byte)
     } else if (prev_status_byte != -1) {
         event_type = static_cast<std::uint8_t>(prev_status_byte);
     } else {
-        throw SightRead::ParseError(
+        return syntax_error(
+            reader.offset(),
             "MIDI Event has no status byte and there is no running status");
     }
 
     if ((event_type & UPPER_NIBBLE_MASK) == SYSTEM_COMMON_MSG_ID) {
-        throw SightRead::ParseError(
+        return syntax_error(
+            reader.offset(),
             "MIDI Events with high nibble 0xF are not supported");
     }
+    const auto data_size = (event_type & UPPER_NIBBLE_MASK) != PROGRAM_CHANGE_ID
+            && (event_type & UPPER_NIBBLE_MASK) != CHANNEL_PRESSURE_ID
+        ? 2U
+        : 1U;
+    if (data.size() < data_size) {
+        return insufficient_bytes(reader.offset());
+    }
     std::array<std::uint8_t, 2> event_data {pop_front(data), 0};
-    if ((event_type & UPPER_NIBBLE_MASK) != PROGRAM_CHANGE_ID
-        && (event_type & UPPER_NIBBLE_MASK) != CHANNEL_PRESSURE_ID) {
+    if (data_size == 2) {
         event_data.at(1) = pop_front(data);
     }
 
-    return {.status = event_type, .data = event_data};
+    return SightRead::Detail::MidiEvent {.status = event_type,
+                                         .data = event_data};
 }
 
-SightRead::Detail::SysexEvent
-read_sysex_event(std::span<const std::uint8_t>& data)
+SightRead::ParseResult<SightRead::Detail::SysexEvent>
+read_sysex_event(ChunkReader& reader)
 {
-    const auto data_length = read_variable_length_num(data);
-    if (static_cast<std::size_t>(data_length) > data.size()) {
-        throw SightRead::ParseError("Sysex Event too long");
+    const auto data_length = read_variable_length_num(reader);
+    if (!data_length) {
+        return data_length.error();
+    }
+    if (static_cast<std::size_t>(*data_length) > reader.data.size()) {
+        return syntax_error(reader.offset(), "Sysex Event too long");
     }
     SightRead::Detail::SysexEvent event;
-    event.data
-        = std::vector<std::uint8_t> {data.begin(), data.begin() + data_length};
-    data = data.subspan(static_cast<std::size_t>(data_length));
+    event.data = reader.data.first(static_cast<std::size_t>(*data_length));
+    reader.data = reader.data.subspan(event.data.size());
     return event;
 }
 
-SightRead::Detail::MidiTrack
-read_midi_track(std::span<const std::uint8_t>& data)
+// chunk_offset is the position of the chunk in the file, used for
+// diagnostics.
+SightRead::ParseResult<std::span<const std::uint8_t>>
+read_track_chunk(std::span<const std::uint8_t>& data, std::size_t chunk_offset)
 {
-    constexpr int META_EVENT_ID = 0xFF;
-    constexpr int SYSEX_EVENT_ID = 0xF0;
     constexpr int TRACK_HEADER_MAGIC_NUMBER = 0x4D54726B;
     constexpr int TRACK_HEADER_SIZE = 8;
 
+    if (data.size() < TRACK_HEADER_SIZE) {
+        return syntax_error(chunk_offset, "insufficient bytes");
+    }
     if (read_four_byte_be<std::int32_t>(data, 0) != TRACK_HEADER_MAGIC_NUMBER) {
-        throw SightRead::ParseError("Invalid MIDI file");
+        return syntax_error(chunk_offset, "Invalid MIDI file");
     }
     const auto track_size = read_four_byte_be<std::int32_t>(data, 4);
     data = data.subspan(TRACK_HEADER_SIZE);
+    if (track_size < 0 || static_cast<std::size_t>(track_size) > data.size()) {
+        return syntax_error(chunk_offset, "insufficient bytes");
+    }
+    const auto chunk = data.first(static_cast<std::size_t>(track_size));
+    data = data.subspan(chunk.size());
+    return chunk;
+}
+
+std::string_view meta_event_text(const SightRead::Detail::MetaEvent& event)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<const char*>(event.data.data()),
+            event.data.size()};
+}
+
+// Returns std::nullopt if the track is rejected by track_filter, in which case
+// decoding stops as soon as the track's name is known. chunk_offset is the
+// position of the chunk's events in the file.
+SightRead::ParseResult<std::optional<SightRead::Detail::MidiTrack>>
+read_midi_track(std::span<const std::uint8_t> chunk, std::size_t chunk_offset,
+                const std::function<bool(std::string_view)>& track_filter)
+{
+    constexpr int META_EVENT_ID = 0xFF;
+    constexpr int SYSEX_EVENT_ID = 0xF0;
+    constexpr int TRACK_NAME_ID = 3;
+
+    ChunkReader reader {.data = chunk, .end_offset = chunk_offset + chunk.size()};
     auto absolute_time = 0;
-    const auto final_span_size
-        = data.size() - static_cast<std::size_t>(track_size);
     auto prev_status_byte = -1;
+    bool has_name = false;
     SightRead::Detail::MidiTrack track;
-    while (data.size() != final_span_size) {
-        const auto delta_time = read_variable_length_num(data);
-        absolute_time += delta_time;
-        SightRead::Detail::TimedEvent event {.time = absolute_time,
-                                             .event = {}};
-        if (data.empty()) {
-            throw_on_insufficient_bytes();
+    while (!reader.data.empty()) {
+        const auto delta_time = read_variable_length_num(reader);
+        if (!delta_time) {
+            return delta_time.error();
+        }
+        absolute_time += *delta_time;
+        if (reader.data.empty()) {
+            return insufficient_bytes(reader.offset());
         }
-        const auto event_type = data.front();
+        const auto event_type = reader.data.front();
         if (event_type == META_EVENT_ID) {
-            data = data.subspan(1);
-            event.event = read_meta_event(data);
+            reader.data = reader.data.subspan(1);
+            const auto meta_event = read_meta_event(reader);
+            if (!meta_event) {
+                return meta_event.error();
+            }
+            if (track_filter && !has_name
+                && meta_event->type == TRACK_NAME_ID) {
+                if (!track_filter(meta_event_text(*meta_event))) {
+                    return std::optional<SightRead::Detail::MidiTrack> {};
+                }
+                has_name = true;
+            }
+            track.add_event(absolute_time, *meta_event);
         } else if (event_type == SYSEX_EVENT_ID) {
-            data = data.subspan(1);
-            event.event = read_sysex_event(data);
+            reader.data = reader.data.subspan(1);
+            const auto sysex_event = read_sysex_event(reader);
+            if (!sysex_event) {
+                return sysex_event.error();
+            }
+            track.add_event(absolute_time, *sysex_event);
         } else {
-            const auto midi_event = read_midi_event(data, prev_status_byte);
-            prev_status_byte = midi_event.status;
-            event.event = midi_event;
+            const auto midi_event = read_midi_event(reader, prev_status_byte);
+            if (!midi_event) {
+                return midi_event.error();
+            }
+            prev_status_byte = midi_event->status;
+            track.add_event(absolute_time, *midi_event);
         }
-        track.events.push_back(std::move(event));
     }
-    return track;
+    if (track_filter && !has_name) {
+        return std::optional<SightRead::Detail::MidiTrack> {};
+    }
+    return std::optional {std::move(track)};
+}
 }
+
+SightRead::Detail::MidiTrack::MidiTrack(const std::vector<TimedEvent>& events)
+{
+    for (const auto& event : events) {
+        std::visit([&](const auto& e) { add_event(event.time, e); },
+                   event.event);
+    }
+}
+
+void SightRead::Detail::MidiTrack::add_event(int time, const MetaEvent& event)
+{
+    meta_events.push_back(
+        {.time = time, .index = static_cast<int>(size()), .event = event});
+}
+
+void SightRead::Detail::MidiTrack::add_event(int time, const MidiEvent& event)
+{
+    midi_indices.push_back(static_cast<int>(size()));
+    midi_times.push_back(time);
+    midi_statuses.push_back(static_cast<std::uint8_t>(event.status));
+    midi_data.push_back(event.data);
+}
+
+void SightRead::Detail::MidiTrack::add_event(int time, const SysexEvent& event)
+{
+    sysex_events.push_back(
+        {.time = time, .index = static_cast<int>(size()), .event = event});
+}
+
+std::size_t SightRead::Detail::MidiTrack::size() const
+{
+    return midi_times.size() + meta_events.size() + sysex_events.size();
+}
+
+std::vector<SightRead::Detail::TimedEvent>
+SightRead::Detail::MidiTrack::events() const
+{
+    std::vector<TimedEvent> events(size());
+    for (auto i = 0U; i < midi_times.size(); ++i) {
+        events.at(static_cast<std::size_t>(midi_indices[i]))
+            = {.time = midi_times[i],
+               .event = MidiEvent {.status = midi_statuses[i],
+                                   .data = midi_data[i]}};
+    }
+    for (const auto& [time, index, event] : meta_events) {
+        events.at(static_cast<std::size_t>(index))
+            = {.time = time, .event = event};
+    }
+    for (const auto& [time, index, event] : sysex_events) {
+        events.at(static_cast<std::size_t>(index))
+            = {.time = time, .event = event};
+    }
+    return events;
 }
 
 SightRead::Detail::Midi
 SightRead::Detail::parse_midi(std::span<const std::uint8_t> data)
 {
+    return parse_midi(data, {});
+}
+
+SightRead::Detail::Midi SightRead::Detail::parse_midi(
+    std::span<const std::uint8_t> data,
+    const std::function<bool(std::string_view)>& track_filter,
+    unsigned int max_threads)
+{
+    return decode_midi_chunks(find_midi_chunks(data).value(), track_filter,
+                              max_threads)
+        .value();
+}
+
+SightRead::ParseResult<SightRead::Detail::MidiChunks>
+SightRead::Detail::find_midi_chunks(std::span<const std::uint8_t> data)
+{
+    const auto file_size = data.size();
     const auto header = read_midi_header(data);
+    if (!header) {
+        return header.error();
+    }
+    MidiChunks chunks {.ticks_per_quarter_note
+                       = header->ticks_per_quarter_note,
+                       .tracks = {},
+                       .track_offsets = {}};
+    for (auto i = 0; i < header->num_of_tracks && !data.empty(); ++i) {
+        const auto chunk = read_track_chunk(data, file_size - data.size());
+        if (!chunk) {
+            return chunk.error();
+        }
+        chunks.tracks.push_back(*chunk);
+        chunks.track_offsets.push_back(file_size - data.size()
+                                       - chunk->size());
+    }
+    return chunks;
+}
+
+SightRead::ParseResult<SightRead::Detail::Midi>
+SightRead::Detail::decode_midi_chunks(
+    const MidiChunks& chunks,
+    const std::function<bool(std::string_view)>& track_filter,
+    unsigned int max_threads)
+{
+    const std::function<bool(std::string_view)> keep_all_tracks;
+
+    auto decoded_tracks
+        = parallel_map(chunks.tracks.size(), max_threads, [&](std::size_t i) {
+              return read_midi_track(chunks.tracks[i], chunks.track_offsets[i],
+                                     i == 0 ? keep_all_tracks : track_filter);
+          });
+
+    // Every track is decoded before errors are checked, so the error reported
+    // is the one in the earliest track regardless of the number of threads.
     std::vector<SightRead::Detail::MidiTrack> tracks;
-    for (auto i = 0; i < header.num_of_tracks && !data.empty(); ++i) {
-        tracks.push_back(read_midi_track(data));
+    for (auto& track : decoded_tracks) {
+        if (!track) {
+            return std::move(track.error());
+        }
+        if (track->has_value()) {
+            tracks.push_back(std::move(**track));
+        }
     }
     return SightRead::Detail::Midi {.ticks_per_quarter_note
-                                    = header.ticks_per_quarter_note,
+                                    = chunks.ticks_per_quarter_note,
                                     .tracks = std::move(tracks)};
 }
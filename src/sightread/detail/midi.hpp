@@ -2,15 +2,22 @@
 #define SIGHTREAD_DETAIL_MIDI_HPP
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <span>
+#include <string_view>
 #include <variant>
 #include <vector>
 
+#include "sightread/parseresult.hpp"
+
 namespace SightRead::Detail {
+// The data of MetaEvents and SysexEvents produced by parse_midi are views into
+// the buffer that was parsed, so a Midi must not outlive that buffer.
 struct MetaEvent {
     int type;
-    std::vector<std::uint8_t> data;
+    std::span<const std::uint8_t> data;
 };
 
 struct MidiEvent {
@@ -19,7 +26,7 @@ struct MidiEvent {
 };
 
 struct SysexEvent {
-    std::vector<std::uint8_t> data;
+    std::span<const std::uint8_t> data;
 };
 
 struct TimedEvent {
@@ -27,8 +34,35 @@ struct TimedEvent {
     std::variant<MetaEvent, MidiEvent, SysexEvent> event;
 };
 
+template <typename Event> struct IndexedEvent {
+    int time;
+    int index;
+    Event event;
+};
+
+// Events are stored column-wise: the times, statuses and data of channel
+// events, which make up the bulk of most tracks, are held in parallel arrays
+// so they can be scanned without touching meta or sysex events, which are kept
+// in side tables. Every event records its index within the track so the
+// relative order of events of different kinds is not lost.
 struct MidiTrack {
-    std::vector<TimedEvent> events;
+    std::vector<int> midi_times;
+    std::vector<int> midi_indices;
+    std::vector<std::uint8_t> midi_statuses;
+    std::vector<std::array<std::uint8_t, 2>> midi_data;
+    std::vector<IndexedEvent<MetaEvent>> meta_events;
+    std::vector<IndexedEvent<SysexEvent>> sysex_events;
+
+    MidiTrack() = default;
+    explicit MidiTrack(const std::vector<TimedEvent>& events);
+
+    void add_event(int time, const MetaEvent& event);
+    void add_event(int time, const MidiEvent& event);
+    void add_event(int time, const SysexEvent& event);
+    // The number of events of all kinds in the track.
+    [[nodiscard]] std::size_t size() const;
+    // Reassembles the track's events in their original order.
+    [[nodiscard]] std::vector<TimedEvent> events() const;
 };
 
 struct Midi {
@@ -36,7 +70,43 @@ struct Midi {
     std::vector<MidiTrack> tracks;
 };
 
+// The header of a MIDI file and the spans of its track chunks, found without
+// decoding any events. track_offsets holds the position in the file of the
+// events of each track, for diagnostics.
+struct MidiChunks {
+    int ticks_per_quarter_note;
+    std::vector<std::span<const std::uint8_t>> tracks;
+    std::vector<std::size_t> track_offsets;
+};
+
+// Returns a diagnostic with the byte offset of the problem instead of throwing
+// if the header or the framing of a track chunk is invalid.
+SightRead::ParseResult<MidiChunks>
+find_midi_chunks(std::span<const std::uint8_t> data);
+
+// Decodes the events of chunks, filtering and decoding tracks as parse_midi
+// does. Returns a diagnostic with the byte offset of the first malformed event
+// instead of throwing.
+SightRead::ParseResult<Midi> decode_midi_chunks(
+    const MidiChunks& chunks,
+    const std::function<bool(std::string_view)>& track_filter,
+    unsigned int max_threads = 1);
+
 Midi parse_midi(std::span<const std::uint8_t> data);
+
+// Like parse_midi, but only tracks whose name (from the first track name meta
+// event) satisfies track_filter are decoded; the remaining track chunks are
+// skipped using their length without decoding the rest of their events. The
+// first track is always kept since it holds the tempo map, and other tracks
+// without a name are dropped. An empty track_filter keeps every track.
+//
+// Track chunks are located up front and decoded on up to max_threads threads
+// (0 means one per hardware thread), so track_filter must be safe to call
+// concurrently. The order of tracks in the result is the order in the file
+// regardless of the number of threads.
+Midi parse_midi(std::span<const std::uint8_t> data,
+                const std::function<bool(std::string_view)>& track_filter,
+                unsigned int max_threads = 1);
 }
 
 #endif
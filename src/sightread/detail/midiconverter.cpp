@@ -3,15 +3,24 @@
 #include <limits>
 #include <stack>
 #include <string_view>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include "sightread/detail/intervalset.hpp"
 #include "sightread/detail/midiconverter.hpp"
+#include "sightread/detail/parallel.hpp"
 #include "sightread/detail/parserutil.hpp"
 
 namespace {
-SightRead::TempoMap
+SightRead::ParseDiagnostic content_error(const char* message)
+{
+    return {.category = SightRead::ParseErrorCategory::Content,
+            .byte_offset = std::nullopt,
+            .message = message};
+}
+
+SightRead::ParseResult<SightRead::TempoMap>
 read_first_midi_track(const SightRead::Detail::MidiTrack& track, int resolution)
 {
     constexpr int SET_TEMPO_ID = 0x51;
@@ -19,59 +28,47 @@ read_first_midi_track(const SightRead::Detail::MidiTrack& track, int resolution)
 
     std::vector<SightRead::BPM> tempos;
     std::vector<SightRead::TimeSignature> time_sigs;
-    for (const auto& event : track.events) {
-        const auto* meta_event
-            = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
-        if (meta_event == nullptr) {
-            continue;
-        }
-        switch (meta_event->type) {
+    for (const auto& [time, index, meta_event] : track.meta_events) {
+        switch (meta_event.type) {
         case SET_TEMPO_ID: {
-            if (meta_event->data.size() < 3) {
-                throw SightRead::ParseError("Tempo meta event too short");
+            if (meta_event.data.size() < 3) {
+                return content_error("Tempo meta event too short");
             }
-            const auto us_per_quarter = meta_event->data.at(0) << 16
-                | meta_event->data.at(1) << 8 | meta_event->data.at(2);
+            const auto us_per_quarter = meta_event.data[0] << 16
+                | meta_event.data[1] << 8 | meta_event.data[2];
             const auto millibeats_per_minute = 60000000000.0 / us_per_quarter;
-            tempos.push_back({.position = SightRead::Tick {event.time},
+            tempos.push_back({.position = SightRead::Tick {time},
                               .millibeats_per_minute = millibeats_per_minute});
             break;
         }
         case TIME_SIG_ID:
-            if (meta_event->data.size() < 2) {
-                throw SightRead::ParseError("Tempo meta event too short");
+            if (meta_event.data.size() < 2) {
+                return content_error("Tempo meta event too short");
             }
-            if (meta_event->data.at(1) >= (CHAR_BIT * sizeof(int))) {
-                throw SightRead::ParseError("Time sig denominator too large");
+            if (meta_event.data[1] >= (CHAR_BIT * sizeof(int))) {
+                return content_error("Time sig denominator too large");
             }
-            time_sigs.push_back({.position = SightRead::Tick {event.time},
-                                 .numerator = meta_event->data.at(0),
-                                 .denominator = 1 << meta_event->data.at(1)});
+            time_sigs.push_back({.position = SightRead::Tick {time},
+                                 .numerator = meta_event.data[0],
+                                 .denominator = 1 << meta_event.data[1]});
             break;
         default:
             break;
         }
     }
 
-    return {std::move(time_sigs), std::move(tempos), {}, resolution};
+    return SightRead::Detail::try_tempo_map(std::move(time_sigs),
+                                            std::move(tempos), {}, resolution);
 }
 
 std::optional<std::string>
 midi_track_name(const SightRead::Detail::MidiTrack& track)
 {
-    if (track.events.empty()) {
-        return std::nullopt;
-    }
-    for (const auto& event : track.events) {
-        const auto* meta_event
-            = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
-        if (meta_event == nullptr) {
+    for (const auto& [time, index, meta_event] : track.meta_events) {
+        if (meta_event.type != 3) {
             continue;
         }
-        if (meta_event->type != 3) {
-            continue;
-        }
-        return std::string {meta_event->data.cbegin(), meta_event->data.cend()};
+        return std::string {meta_event.data.begin(), meta_event.data.end()};
     }
     return std::nullopt;
 }
@@ -86,21 +83,16 @@ od_beats_from_track(const SightRead::Detail::MidiTrack& track)
 
     std::vector<SightRead::Tick> od_beats;
 
-    for (const auto& event : track.events) {
-        const auto* midi_event
-            = std::get_if<SightRead::Detail::MidiEvent>(&event.event);
-        if (midi_event == nullptr) {
+    for (auto i = 0U; i < track.midi_statuses.size(); ++i) {
+        if ((track.midi_statuses[i] & UPPER_NIBBLE_MASK) != NOTE_ON_ID) {
             continue;
         }
-        if ((midi_event->status & UPPER_NIBBLE_MASK) != NOTE_ON_ID) {
+        const auto& data = track.midi_data[i];
+        if (data[1] == 0) {
             continue;
         }
-        if (midi_event->data.at(1) == 0) {
-            continue;
-        }
-        const auto key = midi_event->data.at(0);
-        if (key == BEAT_LOW_KEY || key == BEAT_HIGH_KEY) {
-            od_beats.emplace_back(event.time);
+        if (data[0] == BEAT_LOW_KEY || data[0] == BEAT_HIGH_KEY) {
+            od_beats.emplace_back(track.midi_times[i]);
         }
     }
 
@@ -116,14 +108,11 @@ practice_sections_from_track(const SightRead::Detail::MidiTrack& track)
                                                     "[section_"sv, "[prc_"sv};
 
     std::vector<SightRead::PracticeSection> practice_sections;
-    for (const auto& event : track.events) {
-        const auto* meta_event
-            = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
-        if (meta_event == nullptr || meta_event->type != 1) {
+    for (const auto& [time, index, meta_event] : track.meta_events) {
+        if (meta_event.type != 1) {
             continue;
         }
-        std::span<const std::uint8_t> section_name {meta_event->data.data(),
-                                                    meta_event->data.size()};
+        auto section_name = meta_event.data;
         if (!section_name.empty() && section_name.back() == ']') {
             section_name = section_name.first(section_name.size() - 1);
         }
@@ -136,7 +125,7 @@ practice_sections_from_track(const SightRead::Detail::MidiTrack& track)
             section_name = section_name.subspan(prefix.size());
             practice_sections.push_back(
                 {.name = std::string {section_name.begin(), section_name.end()},
-                 .start = SightRead::Tick {event.time}});
+                 .start = SightRead::Tick {time}});
             break;
         }
     }
@@ -154,99 +143,55 @@ void process_events_track(const SightRead::Detail::MidiTrack& track,
     global_data.practice_sections(practice_sections_from_track(track));
     coda_event_time = std::nullopt;
 
-    for (const auto& event : track.events) {
-        const auto* meta_event
-            = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
-        if (meta_event == nullptr || meta_event->type != 1) {
+    for (const auto& [time, index, meta_event] : track.meta_events) {
+        if (meta_event.type != 1) {
             continue;
         }
-        std::span<const std::uint8_t> event_text {meta_event->data.data(),
-                                                  meta_event->data.size()};
+        const auto event_text = meta_event.data;
         if (event_text.size() != coda_text.size()
             || !std::equal(coda_text.cbegin(), coda_text.cend(),
                            event_text.begin())) {
             continue;
         }
-        coda_event_time = SightRead::Tick {event.time};
+        coda_event_time = SightRead::Tick {time};
     }
 }
 
-bool is_five_lane_green_note(const SightRead::Detail::TimedEvent& event)
+bool is_five_lane_green_key(std::uint8_t key)
 {
     constexpr std::array<std::uint8_t, 4> GREEN_LANE_KEYS {65, 77, 89, 101};
-    constexpr int NOTE_OFF_ID = 0x80;
-    constexpr int NOTE_ON_ID = 0x90;
-    constexpr int UPPER_NIBBLE_MASK = 0xF0;
 
-    const auto* midi_event
-        = std::get_if<SightRead::Detail::MidiEvent>(&event.event);
-    if (midi_event == nullptr) {
-        return false;
-    }
-    const auto event_type = midi_event->status & UPPER_NIBBLE_MASK;
-    if (event_type != NOTE_ON_ID && event_type != NOTE_OFF_ID) {
-        return false;
-    }
-    const auto key = midi_event->data.at(0);
     return std::ranges::find(GREEN_LANE_KEYS, key)
         != std::ranges::end(GREEN_LANE_KEYS);
 }
 
-bool has_five_lane_green_notes(const SightRead::Detail::MidiTrack& midi_track)
-{
-    return std::ranges::find_if(midi_track.events, is_five_lane_green_note)
-        != std::ranges::end(midi_track.events);
-}
-
-bool is_enable_chart_dynamics(const SightRead::Detail::TimedEvent& event)
+bool is_enable_chart_dynamics(const SightRead::Detail::MetaEvent& event)
 {
     using namespace std::literals;
     constexpr std::array ENABLE_DYNAMICS_STRINGS {"[ENABLE_CHART_DYNAMICS]"sv,
                                                   "ENABLE_CHART_DYNAMICS"sv};
 
-    const auto* meta_event
-        = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
-    if (meta_event == nullptr) {
-        return false;
-    }
-    if (meta_event->type != 1) {
+    if (event.type != 1) {
         return false;
     }
     return std::ranges::any_of(ENABLE_DYNAMICS_STRINGS, [&](const auto string) {
-        return std::ranges::equal(meta_event->data, string);
+        return std::ranges::equal(event.data, string);
     });
 }
 
-bool has_enable_chart_dynamics(const SightRead::Detail::MidiTrack& midi_track)
-{
-    return std::ranges::find_if(midi_track.events, is_enable_chart_dynamics)
-        != std::ranges::end(midi_track.events);
-}
-
-bool is_enhanced_opens(const SightRead::Detail::TimedEvent& event)
+bool is_enhanced_opens(const SightRead::Detail::MetaEvent& event)
 {
     using namespace std::literals;
     constexpr std::array ENHANCED_OPENS_STRINGS {"[ENHANCED_OPENS]"sv};
 
-    const auto* meta_event
-        = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
-    if (meta_event == nullptr) {
-        return false;
-    }
-    if (meta_event->type != 1) {
+    if (event.type != 1) {
         return false;
     }
     return std::ranges::any_of(ENHANCED_OPENS_STRINGS, [&](const auto string) {
-        return std::ranges::equal(meta_event->data, string);
+        return std::ranges::equal(event.data, string);
     });
 }
 
-bool has_enhanced_opens(const SightRead::Detail::MidiTrack& midi_track)
-{
-    return std::ranges::find_if(midi_track.events, is_enhanced_opens)
-        != std::ranges::end(midi_track.events);
-}
-
 bool is_open_sysex_event(const SightRead::Detail::SysexEvent& event)
 {
     constexpr std::array<std::tuple<std::size_t, int>, 6> REQUIRED_BYTES {
@@ -259,12 +204,12 @@ bool is_open_sysex_event(const SightRead::Detail::SysexEvent& event)
         return false;
     }
     if (std::ranges::any_of(REQUIRED_BYTES, [&](const auto& pair) {
-            return event.data.at(std::get<0>(pair)) != std::get<1>(pair);
+            return event.data[std::get<0>(pair)] != std::get<1>(pair);
         })) {
         return false;
     }
     return std::ranges::all_of(UPPER_BOUNDS, [&](const auto& pair) {
-        return event.data.at(std::get<0>(pair)) <= std::get<1>(pair);
+        return event.data[std::get<0>(pair)] <= std::get<1>(pair);
     });
 }
 
@@ -471,22 +416,61 @@ combine_note_on_off_events(const std::vector<MidiEventPosition>& on_events,
     return ranges;
 }
 
+// A Note On or Note Off event as it appears in the track, before the key is
+// mapped to a difficulty and colour.
+struct RawNoteEvent {
+    int time;
+    int rank;
+    bool is_note_on;
+    std::array<std::uint8_t, 2> data;
+};
+
+constexpr std::size_t DIFFICULTY_COUNT = 4;
+// Enough for the colours of every track type; see FiveFretNotes, SixFretNotes
+// and DrumNotes.
+constexpr std::size_t NOTE_COLOUR_COUNT = 7;
+// Only the cymbal, ghost and accent flags can differ between the notes of one
+// track, the other flags being fixed by the track type.
+constexpr unsigned int NOTE_ON_FLAGS_MASK = SightRead::FLAGS_CYMBAL
+    | SightRead::FLAGS_GHOST | SightRead::FLAGS_ACCENT;
+constexpr std::size_t NOTE_ON_FLAGS_COUNT = NOTE_ON_FLAGS_MASK + 1;
+
+// Event lists for each difficulty, indexed by difficulty.
+class DifficultyEvents {
+private:
+    std::array<std::vector<MidiEventPosition>, DIFFICULTY_COUNT> m_events;
+
+public:
+    std::vector<MidiEventPosition>& operator[](SightRead::Difficulty diff)
+    {
+        return m_events.at(static_cast<std::size_t>(diff));
+    }
+
+    const std::vector<MidiEventPosition>&
+    operator[](SightRead::Difficulty diff) const
+    {
+        return m_events.at(static_cast<std::size_t>(diff));
+    }
+};
+
+// Note Off events for each colour, indexed by colour.
+using ColourEvents
+    = std::array<std::vector<MidiEventPosition>, NOTE_COLOUR_COUNT>;
+// Note On events for each set of flags, indexed by the flags covered by
+// NOTE_ON_FLAGS_MASK.
+using FlagsEvents
+    = std::array<std::vector<MidiEventPosition>, NOTE_ON_FLAGS_COUNT>;
+// Note On events for each colour and set of flags, indexed by colour.
+using ColourAndFlagsEvents = std::array<FlagsEvents, NOTE_COLOUR_COUNT>;
+
 struct InstrumentMidiTrack {
 public:
-    std::map<std::tuple<SightRead::Difficulty, int, SightRead::NoteFlags>,
-             std::vector<MidiEventPosition>>
-        note_on_events;
-    std::map<std::tuple<SightRead::Difficulty, int>,
-             std::vector<MidiEventPosition>>
-        note_off_events;
-    std::map<SightRead::Difficulty, std::vector<MidiEventPosition>>
-        open_on_events;
-    std::map<SightRead::Difficulty, std::vector<MidiEventPosition>>
-        open_off_events;
-    std::map<SightRead::Difficulty, std::vector<MidiEventPosition>>
-        tap_on_sysex_events;
-    std::map<SightRead::Difficulty, std::vector<MidiEventPosition>>
-        tap_off_sysex_events;
+    std::array<ColourAndFlagsEvents, DIFFICULTY_COUNT> note_on_events;
+    std::array<ColourEvents, DIFFICULTY_COUNT> note_off_events;
+    DifficultyEvents open_on_events;
+    DifficultyEvents open_off_events;
+    DifficultyEvents tap_on_sysex_events;
+    DifficultyEvents tap_off_sysex_events;
     std::vector<MidiEventPosition> yellow_tom_on_events;
     std::vector<MidiEventPosition> yellow_tom_off_events;
     std::vector<MidiEventPosition> blue_tom_on_events;
@@ -501,22 +485,78 @@ public:
     std::vector<MidiEventPosition> tap_off_events;
     std::vector<MidiEventPosition> flam_on_events;
     std::vector<MidiEventPosition> flam_off_events;
-    std::map<SightRead::Difficulty, std::vector<MidiEventPosition>>
-        force_hopo_on_events;
-    std::map<SightRead::Difficulty, std::vector<MidiEventPosition>>
-        force_hopo_off_events;
-    std::map<SightRead::Difficulty, std::vector<MidiEventPosition>>
-        force_strum_on_events;
-    std::map<SightRead::Difficulty, std::vector<MidiEventPosition>>
-        force_strum_off_events;
+    DifficultyEvents force_hopo_on_events;
+    DifficultyEvents force_hopo_off_events;
+    DifficultyEvents force_strum_on_events;
+    DifficultyEvents force_strum_off_events;
     std::vector<MidiEventPosition> fill_on_events;
     std::vector<MidiEventPosition> fill_off_events;
-    std::map<SightRead::Difficulty, std::vector<MidiEventPosition>>
-        disco_flip_on_events;
-    std::map<SightRead::Difficulty, std::vector<MidiEventPosition>>
-        disco_flip_off_events;
+    DifficultyEvents disco_flip_on_events;
+    DifficultyEvents disco_flip_off_events;
 
     InstrumentMidiTrack() = default;
+
+    // Returns a diagnostic if some colour has Note On events but no Note Off
+    // events. Open notes and tap sysex events are only checked for five fret
+    // tracks, the only ones that use them.
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic>
+    check_note_offs(SightRead::TrackType track_type) const
+    {
+        if (track_type == SightRead::TrackType::FiveFret) {
+            for (auto d = 0U; d < DIFFICULTY_COUNT; ++d) {
+                const auto diff = static_cast<SightRead::Difficulty>(d);
+                if (!open_on_events[diff].empty()
+                    && open_off_events[diff].empty()) {
+                    return content_error("No open Note Off events");
+                }
+            }
+            for (auto d = 0U; d < DIFFICULTY_COUNT; ++d) {
+                const auto diff = static_cast<SightRead::Difficulty>(d);
+                if (!tap_on_sysex_events[diff].empty()
+                    && tap_off_sysex_events[diff].empty()) {
+                    return content_error("No tap Note Off events");
+                }
+            }
+        }
+        for (auto d = 0U; d < DIFFICULTY_COUNT; ++d) {
+            for (auto colour = 0U; colour < NOTE_COLOUR_COUNT; ++colour) {
+                if (!note_off_events.at(d).at(colour).empty()) {
+                    continue;
+                }
+                for (const auto& note_ons : note_on_events.at(d).at(colour)) {
+                    if (!note_ons.empty()) {
+                        return content_error(
+                            "No corresponding Note Off events");
+                    }
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Calls func(diff, colour, flags, note_ons, note_offs) for every
+    // difficulty, colour and flags with Note On events, in that order of
+    // precedence, where flags is just the part covered by NOTE_ON_FLAGS_MASK.
+    // check_note_offs must have found nothing wrong.
+    template <typename F> void for_each_note_lane(F func) const
+    {
+        for (auto d = 0U; d < DIFFICULTY_COUNT; ++d) {
+            const auto diff = static_cast<SightRead::Difficulty>(d);
+            for (auto colour = 0U; colour < NOTE_COLOUR_COUNT; ++colour) {
+                const auto& note_offs = note_off_events.at(d).at(colour);
+                for (auto flags = 0U; flags < NOTE_ON_FLAGS_COUNT; ++flags) {
+                    const auto& note_ons
+                        = note_on_events.at(d).at(colour).at(flags);
+                    if (note_ons.empty()) {
+                        continue;
+                    }
+                    func(diff, static_cast<int>(colour),
+                         static_cast<SightRead::NoteFlags>(flags), note_ons,
+                         note_offs);
+                }
+            }
+        }
+    }
 };
 
 bool is_tap_sysex_event(const SightRead::Detail::SysexEvent& event)
@@ -531,15 +571,15 @@ bool is_tap_sysex_event(const SightRead::Detail::SysexEvent& event)
     if (event.data.size() != SYSEX_DATA_SIZE) {
         return false;
     }
-    if (event.data.at(DIFF_INDEX) > 3
-        && event.data.at(DIFF_INDEX) != ALL_DIFFICULTIES) {
+    if (event.data[DIFF_INDEX] > 3
+        && event.data[DIFF_INDEX] != ALL_DIFFICULTIES) {
         return false;
     }
-    if (event.data.at(PS_EVENT_VALUE_INDEX) > 1) {
+    if (event.data[PS_EVENT_VALUE_INDEX] > 1) {
         return false;
     }
     return std::ranges::all_of(REQUIRED_BYTES, [&](const auto& pair) {
-        return event.data.at(std::get<0>(pair)) == std::get<1>(pair);
+        return event.data[std::get<0>(pair)] == std::get<1>(pair);
     });
 }
 
@@ -569,17 +609,21 @@ void add_sysex_event(InstrumentMidiTrack& track,
                      int rank)
 {
     constexpr int SYSEX_ON_INDEX = 6;
-    const auto diffs = difficulties_from_sysex_diff(event.data.at(4));
+
+    if (!is_open_sysex_event(event) && !is_tap_sysex_event(event)) {
+        return;
+    }
+    const auto diffs = difficulties_from_sysex_diff(event.data[4]);
 
     for (auto diff : diffs) {
         if (is_open_sysex_event(event)) {
-            if (event.data.at(SYSEX_ON_INDEX) == 0) {
+            if (event.data[SYSEX_ON_INDEX] == 0) {
                 track.open_off_events[diff].emplace_back(time, rank);
             } else {
                 track.open_on_events[diff].emplace_back(time, rank);
             }
         } else if (is_tap_sysex_event(event)) {
-            if (event.data.at(SYSEX_ON_INDEX) == 0) {
+            if (event.data[SYSEX_ON_INDEX] == 0) {
                 track.tap_off_sysex_events[diff].emplace_back(time, rank);
             } else {
                 track.tap_on_sysex_events[diff].emplace_back(time, rank);
@@ -606,27 +650,30 @@ void append_disco_flip(InstrumentMidiTrack& event_track,
         && meta_event.data.size() != FLIP_END_SIZE) {
         return;
     }
-    if (!std::equal(MIX.cbegin(), MIX.cend(), meta_event.data.cbegin())) {
+    if (!std::equal(MIX.cbegin(), MIX.cend(), meta_event.data.begin())) {
         return;
     }
     if (!std::equal(DRUMS.cbegin(), DRUMS.cend(),
-                    meta_event.data.cbegin() + MIX.size() + 3)) {
+                    meta_event.data.begin() + MIX.size() + 3)) {
         return;
     }
     for (auto space_loc : SPACE_LOCATIONS) {
-        const auto character = meta_event.data.at(space_loc);
+        const auto character = meta_event.data[space_loc];
         if (character != ' ' && character != '_') {
             return;
         }
     }
-    const auto diff = static_cast<SightRead::Difficulty>(
-        meta_event.data.at(MIX.size() + 1) - '0');
+    const auto diff_value = meta_event.data[MIX.size() + 1] - '0';
+    if (diff_value < 0 || diff_value >= static_cast<int>(DIFFICULTY_COUNT)) {
+        return;
+    }
+    const auto diff = static_cast<SightRead::Difficulty>(diff_value);
     if (meta_event.data.size() == FLIP_END_SIZE
-        && meta_event.data.at(FLIP_END_SIZE - 1) == ']') {
+        && meta_event.data[FLIP_END_SIZE - 1] == ']') {
         event_track.disco_flip_off_events[diff].emplace_back(time, rank);
     } else if (meta_event.data.size() == FLIP_START_SIZE
-               && meta_event.data.at(FLIP_START_SIZE - 2) == 'd'
-               && meta_event.data.at(FLIP_START_SIZE - 1) == ']') {
+               && meta_event.data[FLIP_START_SIZE - 2] == 'd'
+               && meta_event.data[FLIP_START_SIZE - 1] == ']') {
         event_track.disco_flip_on_events[diff].emplace_back(time, rank);
     }
 }
@@ -676,7 +723,9 @@ void add_note_off_event(InstrumentMidiTrack& track,
         } else {
             const auto colour = colour_from_key(
                 data.at(0), track_type, from_five_lane, enable_enhanced_opens);
-            track.note_off_events[{*diff, colour}].emplace_back(time, rank);
+            track.note_off_events.at(static_cast<std::size_t>(*diff))
+                .at(static_cast<std::size_t>(colour))
+                .emplace_back(time, rank);
         }
     } else {
         switch (data.at(0)) {
@@ -753,8 +802,10 @@ void add_note_on_event(InstrumentMidiTrack& track,
                         flags | dynamics_flags_from_velocity(data.at(1)));
                 }
             }
-            track.note_on_events[{*diff, colour, flags}].emplace_back(time,
-                                                                      rank);
+            track.note_on_events.at(static_cast<std::size_t>(*diff))
+                .at(static_cast<std::size_t>(colour))
+                .at(flags & NOTE_ON_FLAGS_MASK)
+                .emplace_back(time, rank);
         }
     } else {
         switch (data.at(0)) {
@@ -799,71 +850,73 @@ read_instrument_midi_track(const SightRead::Detail::MidiTrack& midi_track,
         SightRead::Difficulty::Easy, SightRead::Difficulty::Medium,
         SightRead::Difficulty::Hard, SightRead::Difficulty::Expert};
 
-    const bool from_five_lane = track_type == SightRead::TrackType::Drums
-        && has_five_lane_green_notes(midi_track);
-    const bool parse_dynamics = track_type == SightRead::TrackType::Drums
-        && has_enable_chart_dynamics(midi_track);
-    const bool enable_enhanced_opens
-        = track_type == SightRead::TrackType::FiveFret
-        && has_enhanced_opens(midi_track);
-
     InstrumentMidiTrack event_track;
-    for (auto d : DIFFICULTIES) {
-        event_track.disco_flip_on_events[d] = {};
-        event_track.disco_flip_off_events[d] = {};
-        event_track.force_hopo_on_events[d] = {};
-        event_track.force_hopo_off_events[d] = {};
-        event_track.force_strum_on_events[d] = {};
-        event_track.force_strum_off_events[d] = {};
-    }
-
-    int rank = 0;
-    for (const auto& event : midi_track.events) {
-        ++rank;
-        const auto* midi_event
-            = std::get_if<SightRead::Detail::MidiEvent>(&event.event);
-        if (midi_event == nullptr) {
-            const auto* sysex_event
-                = std::get_if<SightRead::Detail::SysexEvent>(&event.event);
-            if (sysex_event != nullptr) {
-                add_sysex_event(event_track, *sysex_event, event.time, rank);
-                continue;
-            }
-            if (track_type == SightRead::TrackType::Drums) {
-                const auto* meta_event
-                    = std::get_if<SightRead::Detail::MetaEvent>(&event.event);
-                if (meta_event != nullptr) {
-                    append_disco_flip(event_track, *meta_event, event.time,
-                                      rank);
-                }
-            }
 
+    // Each list of events in an InstrumentMidiTrack is fed by only one kind
+    // of MIDI event, so the kinds can be read in separate passes without
+    // changing the order of any list. Ranks are one more than an event's index
+    // in the track.
+    //
+    // How note events are read depends on modes that can be switched on by
+    // events anywhere in the track, so every event is visited once to find
+    // the modes and collect the note events, and the note events are only
+    // interpreted afterwards.
+    bool has_five_lane_greens = false;
+    std::vector<RawNoteEvent> note_events;
+    note_events.reserve(midi_track.midi_statuses.size());
+    for (auto i = 0U; i < midi_track.midi_statuses.size(); ++i) {
+        const auto event_type = midi_track.midi_statuses[i] & UPPER_NIBBLE_MASK;
+        if (event_type != NOTE_ON_ID && event_type != NOTE_OFF_ID) {
             continue;
         }
-        switch (midi_event->status & UPPER_NIBBLE_MASK) {
-        case NOTE_OFF_ID:
-            add_note_off_event(event_track, midi_event->data, event.time, rank,
-                               from_five_lane, enable_enhanced_opens,
-                               track_type);
-            break;
-        case NOTE_ON_ID:
-            add_note_on_event(event_track, midi_event->data, event.time, rank,
+        const auto& data = midi_track.midi_data[i];
+        has_five_lane_greens
+            = has_five_lane_greens || is_five_lane_green_key(data[0]);
+        note_events.push_back({.time = midi_track.midi_times[i],
+                               .rank = midi_track.midi_indices[i] + 1,
+                               .is_note_on = event_type == NOTE_ON_ID,
+                               .data = data});
+    }
+
+    bool has_chart_dynamics = false;
+    bool has_enhanced_opens = false;
+    for (const auto& [time, index, meta_event] : midi_track.meta_events) {
+        has_chart_dynamics
+            = has_chart_dynamics || is_enable_chart_dynamics(meta_event);
+        has_enhanced_opens
+            = has_enhanced_opens || is_enhanced_opens(meta_event);
+        if (track_type == SightRead::TrackType::Drums) {
+            append_disco_flip(event_track, meta_event, time, index + 1);
+        }
+    }
+    for (const auto& [time, index, sysex_event] : midi_track.sysex_events) {
+        add_sysex_event(event_track, sysex_event, time, index + 1);
+    }
+
+    const bool from_five_lane
+        = track_type == SightRead::TrackType::Drums && has_five_lane_greens;
+    const bool parse_dynamics
+        = track_type == SightRead::TrackType::Drums && has_chart_dynamics;
+    const bool enable_enhanced_opens
+        = track_type == SightRead::TrackType::FiveFret && has_enhanced_opens;
+    for (const auto& event : note_events) {
+        if (event.is_note_on) {
+            add_note_on_event(event_track, event.data, event.time, event.rank,
                               from_five_lane, parse_dynamics,
                               enable_enhanced_opens, track_type);
-            break;
-        default:
-            break;
+        } else {
+            add_note_off_event(event_track, event.data, event.time, event.rank,
+                               from_five_lane, enable_enhanced_opens,
+                               track_type);
         }
     }
 
-    event_track.disco_flip_off_events.at(SightRead::Difficulty::Easy)
-        .emplace_back(std::numeric_limits<int>::max(), ++rank);
-    event_track.disco_flip_off_events.at(SightRead::Difficulty::Medium)
-        .emplace_back(std::numeric_limits<int>::max(), ++rank);
-    event_track.disco_flip_off_events.at(SightRead::Difficulty::Hard)
-        .emplace_back(std::numeric_limits<int>::max(), ++rank);
-    event_track.disco_flip_off_events.at(SightRead::Difficulty::Expert)
-        .emplace_back(std::numeric_limits<int>::max(), ++rank);
+    auto rank = static_cast<int>(midi_track.size());
+
+    for (auto d : DIFFICULTIES) {
+        event_track.disco_flip_off_events[d].emplace_back(
+            std::numeric_limits<int>::max(), ++rank);
+    }
 
     if (event_track.sp_on_events.empty()
         && event_track.solo_on_events.size() > 1) {
@@ -890,13 +943,14 @@ track_sp_phrases(const InstrumentMidiTrack& event_track)
     return sp_phrases;
 }
 
-std::vector<SightRead::Solo>
+SightRead::ParseResult<std::vector<SightRead::Solo>>
 track_solos(const InstrumentMidiTrack& event_track,
             const std::vector<SightRead::Note>& notes,
-            SightRead::TrackType track_type, bool permit_solos)
+            SightRead::TrackType track_type, bool permit_solos,
+            const SightRead::Detail::LimitChecker& limit_checker)
 {
     if (!permit_solos) {
-        return {};
+        return std::vector<SightRead::Solo> {};
     }
 
     std::vector<int> solo_ons;
@@ -912,7 +966,8 @@ track_solos(const InstrumentMidiTrack& event_track,
 
     return SightRead::Detail::form_solo_vector(
         solo_ons, solo_offs, notes, track_type,
-        SightRead::SoloParsingBehaviour::PreferEarlierStarts, true);
+        SightRead::SoloParsingBehaviour::PreferEarlierStarts, true,
+        limit_checker);
 }
 
 void apply_forcing(
@@ -933,13 +988,13 @@ void apply_forcing(
     for (auto d : DIFFICULTIES) {
         force_hopo_events.emplace(
             d,
-            combine_note_on_off_events(event_track.force_hopo_on_events.at(d),
-                                       event_track.force_hopo_off_events.at(d),
+            combine_note_on_off_events(event_track.force_hopo_on_events[d],
+                                       event_track.force_hopo_off_events[d],
                                        true));
         force_strum_events.emplace(
             d,
-            combine_note_on_off_events(event_track.force_strum_on_events.at(d),
-                                       event_track.force_strum_off_events.at(d),
+            combine_note_on_off_events(event_track.force_strum_on_events[d],
+                                       event_track.force_strum_off_events[d],
                                        true));
     }
 
@@ -976,12 +1031,9 @@ notes_from_event_track(
     SightRead::TrackType track_type, int sustain_cutoff_threshold)
 {
     std::map<SightRead::Difficulty, std::vector<SightRead::Note>> notes;
-    for (const auto& [key, note_ons] : event_track.note_on_events) {
-        const auto& [diff, colour, flags] = key;
-        if (!event_track.note_off_events.contains({diff, colour})) {
-            throw SightRead::ParseError("No corresponding Note Off events");
-        }
-        const auto& note_offs = event_track.note_off_events.at({diff, colour});
+    event_track.for_each_note_lane([&](auto diff, auto colour, auto /*flags*/,
+                                       const auto& note_ons,
+                                       const auto& note_offs) {
         for (const auto& [pos, end] :
              combine_note_on_off_events(note_ons, note_offs)) {
             auto note_length = end - pos;
@@ -1003,7 +1055,7 @@ notes_from_event_track(
             note.flags = flags_from_track_type(track_type);
             notes[diff].push_back(note);
         }
-    }
+    });
 
     if (track_type != SightRead::TrackType::Drums) {
         apply_forcing(notes, event_track, tap_events);
@@ -1012,14 +1064,20 @@ notes_from_event_track(
     return notes;
 }
 
-std::map<SightRead::Difficulty, SightRead::NoteTrack> ghl_note_tracks_from_midi(
+SightRead::ParseResult<std::map<SightRead::Difficulty, SightRead::NoteTrack>>
+ghl_note_tracks_from_midi(
     const SightRead::Detail::MidiTrack& midi_track,
     const std::shared_ptr<SightRead::SongGlobalData>& global_data,
     const SightRead::HopoThreshold& hopo_threshold,
-    int sustain_cutoff_threshold, bool permit_solos, bool allow_open_chords)
+    int sustain_cutoff_threshold, bool permit_solos, bool allow_open_chords,
+    const SightRead::Detail::LimitChecker& limit_checker)
 {
     const auto event_track
         = read_instrument_midi_track(midi_track, SightRead::TrackType::SixFret);
+    if (auto error
+        = event_track.check_note_offs(SightRead::TrackType::SixFret)) {
+        return std::move(*error);
+    }
 
     const auto notes = notes_from_event_track(event_track, {}, {},
                                               SightRead::TrackType::SixFret,
@@ -1028,14 +1086,18 @@ std::map<SightRead::Difficulty, SightRead::NoteTrack> ghl_note_tracks_from_midi(
 
     std::map<SightRead::Difficulty, SightRead::NoteTrack> note_tracks;
     for (const auto& [diff, note_set] : notes) {
-        auto solos = track_solos(event_track, note_set,
-                                 SightRead::TrackType::SixFret, permit_solos);
+        auto solos
+            = track_solos(event_track, note_set, SightRead::TrackType::SixFret,
+                          permit_solos, limit_checker);
+        if (!solos) {
+            return std::move(solos.error());
+        }
         SightRead::NoteTrack note_track {
             note_set, SightRead::TrackType::SixFret, global_data,
             allow_open_chords,
             hopo_threshold.midi_max_hopo_gap(global_data->resolution())};
         note_track.sp_phrases(sp_phrases);
-        note_track.solos(std::move(solos));
+        note_track.solos(std::move(*solos));
         note_tracks.emplace(diff, std::move(note_track));
     }
 
@@ -1099,27 +1161,26 @@ void fix_double_greens(std::vector<SightRead::Note>& notes)
     }
 }
 
-std::map<SightRead::Difficulty, SightRead::NoteTrack>
+SightRead::ParseResult<std::map<SightRead::Difficulty, SightRead::NoteTrack>>
 drum_note_tracks_from_midi(
     const SightRead::Detail::MidiTrack& midi_track,
     const std::shared_ptr<SightRead::SongGlobalData>& global_data,
     int sustain_cutoff_threshold, bool permit_solos,
-    std::optional<SightRead::Tick> coda_event_time)
+    std::optional<SightRead::Tick> coda_event_time,
+    const SightRead::Detail::LimitChecker& limit_checker)
 {
     const auto event_track
         = read_instrument_midi_track(midi_track, SightRead::TrackType::Drums);
+    if (auto error = event_track.check_note_offs(SightRead::TrackType::Drums)) {
+        return std::move(*error);
+    }
 
     const TomEvents tom_events {event_track};
 
     std::map<SightRead::Difficulty, std::vector<SightRead::Note>> notes;
-    for (const auto& [key, note_ons] : event_track.note_on_events) {
-        const auto& [diff, colour, flags] = key;
-        const std::tuple<SightRead::Difficulty, int> no_flags_key {diff,
-                                                                   colour};
-        if (!event_track.note_off_events.contains(no_flags_key)) {
-            throw SightRead::ParseError("No corresponding Note Off events");
-        }
-        const auto& note_offs = event_track.note_off_events.at(no_flags_key);
+    event_track.for_each_note_lane([&](auto diff, auto colour, auto flags,
+                                       const auto& note_ons,
+                                       const auto& note_offs) {
         for (const auto& [pos, end] :
              combine_note_on_off_events(note_ons, note_offs)) {
             auto note_length = end - pos;
@@ -1130,7 +1191,8 @@ drum_note_tracks_from_midi(
             note.position = SightRead::Tick {pos};
             note.lengths.at(static_cast<unsigned int>(colour))
                 = SightRead::Tick {note_length};
-            note.flags = flags;
+            note.flags = static_cast<SightRead::NoteFlags>(
+                flags | SightRead::FLAGS_DRUMS);
             if (tom_events.force_tom(colour, pos)) {
                 note.flags = static_cast<SightRead::NoteFlags>(
                     note.flags & ~SightRead::FLAGS_CYMBAL);
@@ -1138,7 +1200,7 @@ drum_note_tracks_from_midi(
             notes[diff].push_back(note);
         }
         fix_double_greens(notes[diff]);
-    }
+    });
 
     const auto sp_phrases = track_sp_phrases(event_track);
 
@@ -1166,18 +1228,22 @@ drum_note_tracks_from_midi(
     for (const auto& [diff, note_set] : notes) {
         std::vector<SightRead::DiscoFlip> disco_flips;
         for (const auto& [start, end] : combine_note_on_off_events(
-                 event_track.disco_flip_on_events.at(diff),
-                 event_track.disco_flip_off_events.at(diff))) {
+                 event_track.disco_flip_on_events[diff],
+                 event_track.disco_flip_off_events[diff])) {
             disco_flips.push_back({.position = SightRead::Tick {start},
                                    .length = SightRead::Tick {end - start}});
         }
 
         auto solos = track_solos(event_track, note_set,
-                                 SightRead::TrackType::Drums, permit_solos);
+                                 SightRead::TrackType::Drums, permit_solos,
+                                 limit_checker);
+        if (!solos) {
+            return std::move(solos.error());
+        }
         SightRead::NoteTrack note_track {note_set, SightRead::TrackType::Drums,
                                          global_data};
         note_track.sp_phrases(sp_phrases);
-        note_track.solos(std::move(solos));
+        note_track.solos(std::move(*solos));
         note_track.bres(bres);
         note_track.drum_fills(drum_fills);
         note_track.disco_flips(disco_flips);
@@ -1216,15 +1282,20 @@ bool is_fortnite_instrument(SightRead::Instrument instrument)
     return fortnite_instruments.contains(instrument);
 }
 
-std::map<SightRead::Difficulty, SightRead::NoteTrack>
+SightRead::ParseResult<std::map<SightRead::Difficulty, SightRead::NoteTrack>>
 fortnite_note_tracks_from_midi(
     const SightRead::Detail::MidiTrack& midi_track,
     const std::shared_ptr<SightRead::SongGlobalData>& global_data,
     int sustain_cutoff_threshold, bool permit_solos,
-    std::optional<SightRead::Tick> coda_event_time)
+    std::optional<SightRead::Tick> coda_event_time,
+    const SightRead::Detail::LimitChecker& limit_checker)
 {
     const auto event_track = read_instrument_midi_track(
         midi_track, SightRead::TrackType::FortniteFestival);
+    if (auto error = event_track.check_note_offs(
+            SightRead::TrackType::FortniteFestival)) {
+        return std::move(*error);
+    }
     const auto bres = read_bres(event_track, coda_event_time);
 
     const auto notes = notes_from_event_track(
@@ -1234,13 +1305,16 @@ fortnite_note_tracks_from_midi(
 
     std::map<SightRead::Difficulty, SightRead::NoteTrack> note_tracks;
     for (const auto& [diff, note_set] : notes) {
-        auto solos
-            = track_solos(event_track, note_set,
-                          SightRead::TrackType::FortniteFestival, permit_solos);
+        auto solos = track_solos(event_track, note_set,
+                                 SightRead::TrackType::FortniteFestival,
+                                 permit_solos, limit_checker);
+        if (!solos) {
+            return std::move(solos.error());
+        }
         SightRead::NoteTrack note_track {
             note_set, SightRead::TrackType::FortniteFestival, global_data};
         note_track.sp_phrases(sp_phrases);
-        note_track.solos(std::move(solos));
+        note_track.solos(std::move(*solos));
         note_track.bres(bres);
         note_tracks.emplace(diff, std::move(note_track));
     }
@@ -1248,34 +1322,46 @@ fortnite_note_tracks_from_midi(
     return note_tracks;
 }
 
-std::map<SightRead::Difficulty, SightRead::NoteTrack> note_tracks_from_midi(
+SightRead::ParseResult<std::map<SightRead::Difficulty, SightRead::NoteTrack>>
+note_tracks_from_midi(
     const SightRead::Detail::MidiTrack& midi_track,
     const std::shared_ptr<SightRead::SongGlobalData>& global_data,
     const SightRead::HopoThreshold& hopo_threshold,
     int sustain_cutoff_threshold, bool permit_solos, bool allow_open_chords,
-    std::optional<SightRead::Tick> coda_event_time)
+    std::optional<SightRead::Tick> coda_event_time,
+    const SightRead::Detail::LimitChecker& limit_checker)
 {
+    constexpr std::array DIFFICULTIES {
+        SightRead::Difficulty::Easy, SightRead::Difficulty::Medium,
+        SightRead::Difficulty::Hard, SightRead::Difficulty::Expert};
+
     const auto event_track = read_instrument_midi_track(
         midi_track, SightRead::TrackType::FiveFret);
+    if (auto error
+        = event_track.check_note_offs(SightRead::TrackType::FiveFret)) {
+        return std::move(*error);
+    }
     const auto bres = read_bres(event_track, coda_event_time);
 
     std::map<SightRead::Difficulty, ClosedIntervalSet<int>> open_events;
-    for (const auto& [diff, open_ons] : event_track.open_on_events) {
-        if (!event_track.open_off_events.contains(diff)) {
-            throw SightRead::ParseError("No open Note Off events");
+    std::map<SightRead::Difficulty, HalfOpenIntervalSet<int>> tap_events;
+    for (auto diff : DIFFICULTIES) {
+        const auto& open_ons = event_track.open_on_events[diff];
+        if (!open_ons.empty()) {
+            open_events.emplace(
+                diff,
+                combine_note_on_off_events(open_ons,
+                                           event_track.open_off_events[diff]));
         }
-        const auto& open_offs = event_track.open_off_events.at(diff);
-        open_events.emplace(diff,
-                            combine_note_on_off_events(open_ons, open_offs));
     }
-
-    std::map<SightRead::Difficulty, HalfOpenIntervalSet<int>> tap_events;
-    for (const auto& [diff, tap_ons] : event_track.tap_on_sysex_events) {
-        if (!event_track.tap_off_sysex_events.contains(diff)) {
-            throw SightRead::ParseError("No tap Note Off events");
+    for (auto diff : DIFFICULTIES) {
+        const auto& tap_ons = event_track.tap_on_sysex_events[diff];
+        if (!tap_ons.empty()) {
+            tap_events.emplace(
+                diff,
+                combine_note_on_off_events(
+                    tap_ons, event_track.tap_off_sysex_events[diff]));
         }
-        const auto& tap_offs = event_track.tap_off_sysex_events.at(diff);
-        tap_events.emplace(diff, combine_note_on_off_events(tap_ons, tap_offs));
     }
 
     const auto notes = notes_from_event_track(
@@ -1286,13 +1372,17 @@ std::map<SightRead::Difficulty, SightRead::NoteTrack> note_tracks_from_midi(
     std::map<SightRead::Difficulty, SightRead::NoteTrack> note_tracks;
     for (const auto& [diff, note_set] : notes) {
         auto solos = track_solos(event_track, note_set,
-                                 SightRead::TrackType::FiveFret, permit_solos);
+                                 SightRead::TrackType::FiveFret, permit_solos,
+                                 limit_checker);
+        if (!solos) {
+            return std::move(solos.error());
+        }
         SightRead::NoteTrack note_track {
             note_set, SightRead::TrackType::FiveFret, global_data,
             allow_open_chords,
             hopo_threshold.midi_max_hopo_gap(global_data->resolution())};
         note_track.sp_phrases(sp_phrases);
-        note_track.solos(std::move(solos));
+        note_track.solos(std::move(*solos));
         note_track.bres(bres);
         note_tracks.emplace(diff, std::move(note_track));
     }
@@ -1307,6 +1397,8 @@ SightRead::Detail::MidiConverter::MidiConverter(SightRead::Metadata metadata)
     , m_permit_solos {true}
     , m_allow_open_chords {true}
     , m_use_sustain_cutoff_threshold {true}
+    , m_max_threads {1}
+    , m_limit_checker {SightRead::ParseLimits {}}
 {
 }
 
@@ -1340,6 +1432,21 @@ SightRead::Detail::MidiConverter::use_sustain_cutoff_threshold(
     return *this;
 }
 
+SightRead::Detail::MidiConverter&
+SightRead::Detail::MidiConverter::max_threads(unsigned int max_threads)
+{
+    m_max_threads = max_threads;
+    return *this;
+}
+
+SightRead::Detail::MidiConverter&
+SightRead::Detail::MidiConverter::limit_checker(
+    const SightRead::Detail::LimitChecker& limit_checker)
+{
+    m_limit_checker = limit_checker;
+    return *this;
+}
+
 int SightRead::Detail::MidiConverter::sustain_cutoff_threshold(
     int resolution) const
 {
@@ -1391,54 +1498,59 @@ SightRead::Detail::MidiConverter::midi_section_instrument(
     return std::nullopt;
 }
 
-void SightRead::Detail::MidiConverter::process_instrument_track(
-    const std::string& track_name, const SightRead::Detail::MidiTrack& track,
-    SightRead::Song& song, std::optional<SightRead::Tick> coda_event_time) const
+bool SightRead::Detail::MidiConverter::is_track_used(
+    std::string_view track_name) const
 {
-    const auto inst = midi_section_instrument(track_name);
-    if (!inst.has_value()) {
-        return;
+    if (track_name == "BEAT" || track_name == "EVENTS") {
+        return true;
     }
+    return midi_section_instrument(std::string {track_name}).has_value();
+}
 
-    const auto sustain_threshold
-        = sustain_cutoff_threshold(song.global_data().resolution());
-    if (is_fortnite_instrument(*inst)) {
-        auto tracks = fortnite_note_tracks_from_midi(
-            track, song.global_data_ptr(), sustain_threshold, m_permit_solos,
-            coda_event_time);
-        for (auto& [diff, note_track] : tracks) {
-            song.add_note_track(*inst, diff, std::move(note_track));
-        }
-    } else if (SightRead::Detail::is_six_fret_instrument(*inst)) {
-        auto tracks = ghl_note_tracks_from_midi(
-            track, song.global_data_ptr(), m_metadata.hopo_threshold,
-            sustain_threshold, m_permit_solos, m_allow_open_chords);
-        for (auto& [diff, note_track] : tracks) {
-            song.add_note_track(*inst, diff, std::move(note_track));
-        }
-    } else if (*inst == SightRead::Instrument::Drums) {
-        auto tracks = drum_note_tracks_from_midi(
-            track, song.global_data_ptr(), sustain_threshold, m_permit_solos,
-            coda_event_time);
-        for (auto& [diff, note_track] : tracks) {
-            song.add_note_track(*inst, diff, std::move(note_track));
-        }
-    } else {
-        auto tracks = note_tracks_from_midi(
-            track, song.global_data_ptr(), m_metadata.hopo_threshold,
-            sustain_threshold, m_permit_solos, m_allow_open_chords,
-            coda_event_time);
-        for (auto& [diff, note_track] : tracks) {
-            song.add_note_track(*inst, diff, std::move(note_track));
-        }
+SightRead::ParseResult<std::map<SightRead::Difficulty, SightRead::NoteTrack>>
+SightRead::Detail::MidiConverter::instrument_note_tracks(
+    SightRead::Instrument instrument, const SightRead::Detail::MidiTrack& track,
+    const std::shared_ptr<SightRead::SongGlobalData>& global_data,
+    std::optional<SightRead::Tick> coda_event_time) const
+{
+    if (auto exceeded = m_limit_checker.check_time()) {
+        return std::move(*exceeded);
     }
+    const auto sustain_threshold
+        = sustain_cutoff_threshold(global_data->resolution());
+    if (is_fortnite_instrument(instrument)) {
+        return fortnite_note_tracks_from_midi(
+            track, global_data, sustain_threshold, m_permit_solos,
+            coda_event_time, m_limit_checker);
+    }
+    if (SightRead::Detail::is_six_fret_instrument(instrument)) {
+        return ghl_note_tracks_from_midi(
+            track, global_data, m_metadata.hopo_threshold, sustain_threshold,
+            m_permit_solos, m_allow_open_chords, m_limit_checker);
+    }
+    if (instrument == SightRead::Instrument::Drums) {
+        return drum_note_tracks_from_midi(track, global_data,
+                                          sustain_threshold, m_permit_solos,
+                                          coda_event_time, m_limit_checker);
+    }
+    return note_tracks_from_midi(track, global_data, m_metadata.hopo_threshold,
+                                 sustain_threshold, m_permit_solos,
+                                 m_allow_open_chords, coda_event_time,
+                                 m_limit_checker);
 }
 
 SightRead::Song SightRead::Detail::MidiConverter::convert(
     const SightRead::Detail::Midi& midi) const
+{
+    return try_convert(midi).value();
+}
+
+SightRead::ParseResult<SightRead::Song>
+SightRead::Detail::MidiConverter::try_convert(
+    const SightRead::Detail::Midi& midi) const
 {
     if (midi.ticks_per_quarter_note == 0) {
-        throw SightRead::ParseError("Resolution must be > 0");
+        return content_error("Resolution must be > 0");
     }
 
     SightRead::Song song;
@@ -1453,34 +1565,65 @@ SightRead::Song SightRead::Detail::MidiConverter::convert(
         return song;
     }
 
-    song.global_data().tempo_map(
-        read_first_midi_track(midi.tracks.at(0), midi.ticks_per_quarter_note));
+    auto tempo_map
+        = read_first_midi_track(midi.tracks.at(0), midi.ticks_per_quarter_note);
+    if (!tempo_map) {
+        return std::move(tempo_map.error());
+    }
+    song.global_data().tempo_map(std::move(*tempo_map));
 
-    std::map<std::string, MidiTrack> tracks_with_names;
+    // Indexes the tracks held by midi rather than copying them. If several
+    // tracks share a name, the first one is used.
+    std::map<std::string, const MidiTrack*> tracks_with_names;
     for (const auto& track : midi.tracks) {
         const auto track_name = midi_track_name(track);
         if (track_name.has_value()) {
-            tracks_with_names.insert({*track_name, track});
+            tracks_with_names.emplace(*track_name, &track);
         }
     }
 
     const auto beat_iter = tracks_with_names.find("BEAT");
     if (beat_iter != tracks_with_names.end()) {
-        song.global_data().od_beats(od_beats_from_track(beat_iter->second));
+        song.global_data().od_beats(od_beats_from_track(*beat_iter->second));
     }
 
     std::optional<SightRead::Tick> coda_event_time;
     const auto events_iter = tracks_with_names.find("EVENTS");
     if (events_iter != tracks_with_names.end()) {
-        process_events_track(events_iter->second, song.global_data(),
+        process_events_track(*events_iter->second, song.global_data(),
                              coda_event_time);
     }
 
+    std::vector<std::tuple<SightRead::Instrument, const MidiTrack*>>
+        instrument_tracks;
     for (const auto& [name, track] : tracks_with_names) {
         if (name == "BEAT" || name == "EVENTS") {
             continue;
         }
-        process_instrument_track(name, track, song, coda_event_time);
+        const auto inst = midi_section_instrument(name);
+        if (inst.has_value()) {
+            instrument_tracks.emplace_back(*inst, track);
+        }
+    }
+
+    // Instruments only read the song's global data, so their tracks can be
+    // built independently. They are added to the song in the same order
+    // whether or not that happens in parallel.
+    const auto& global_data = song.global_data_ptr();
+    auto note_tracks = parallel_map(
+        instrument_tracks.size(), m_max_threads, [&](std::size_t i) {
+            const auto& [inst, track] = instrument_tracks[i];
+            return instrument_note_tracks(inst, *track, global_data,
+                                          coda_event_time);
+        });
+    for (auto i = 0U; i < instrument_tracks.size(); ++i) {
+        if (!note_tracks[i]) {
+            return std::move(note_tracks[i].error());
+        }
+        const auto inst = std::get<0>(instrument_tracks[i]);
+        for (auto& [diff, note_track] : *note_tracks[i]) {
+            song.add_note_track(inst, diff, std::move(note_track));
+        }
     }
 
     const auto& od_beats = song.global_data().od_beats();
@@ -1,10 +1,14 @@
 #ifndef SIGHTREAD_DETAIL_MIDICONVERTER_HPP
 #define SIGHTREAD_DETAIL_MIDICONVERTER_HPP
 
+#include <map>
+#include <memory>
 #include <optional>
 #include <set>
 #include <string>
+#include <string_view>
 
+#include "sightread/detail/limitchecker.hpp"
 #include "sightread/detail/midi.hpp"
 #include "sightread/metadata.hpp"
 #include "sightread/song.hpp"
@@ -18,12 +22,17 @@ private:
     bool m_permit_solos;
     bool m_allow_open_chords;
     bool m_use_sustain_cutoff_threshold;
+    unsigned int m_max_threads;
+    SightRead::Detail::LimitChecker m_limit_checker;
 
     [[nodiscard]] std::optional<SightRead::Instrument>
     midi_section_instrument(const std::string& track_name) const;
-    void process_instrument_track(
-        const std::string& track_name,
-        const SightRead::Detail::MidiTrack& track, SightRead::Song& song,
+    [[nodiscard]] SightRead::ParseResult<
+        std::map<SightRead::Difficulty, SightRead::NoteTrack>>
+    instrument_note_tracks(
+        SightRead::Instrument instrument,
+        const SightRead::Detail::MidiTrack& track,
+        const std::shared_ptr<SightRead::SongGlobalData>& global_data,
         std::optional<SightRead::Tick> coda_event_time) const;
     [[nodiscard]] int sustain_cutoff_threshold(int resolution) const;
 
@@ -35,8 +44,24 @@ public:
     MidiConverter& allow_open_chords(bool allow_open_chords);
     MidiConverter&
     use_sustain_cutoff_threshold(bool use_sustain_cutoff_threshold);
+    // Sets the number of threads instrument tracks may be converted on, where
+    // 0 means one per hardware thread. The result does not depend on this.
+    MidiConverter& max_threads(unsigned int max_threads);
+    // Sets the checker whose time budget conversion is held to. convert throws
+    // SightRead::ParseLimitError once the budget runs out, including partway
+    // through a track, and try_convert returns a diagnostic. By default there
+    // is no budget.
+    MidiConverter&
+    limit_checker(const SightRead::Detail::LimitChecker& limit_checker);
+    // Whether convert makes any use of a track with this name, so tracks
+    // for which this is false need not be decoded.
+    [[nodiscard]] bool is_track_used(std::string_view track_name) const;
     [[nodiscard]] SightRead::Song
     convert(const SightRead::Detail::Midi& midi) const;
+    // Like convert, but returns a diagnostic instead of throwing if the MIDI
+    // does not describe a usable song.
+    [[nodiscard]] SightRead::ParseResult<SightRead::Song>
+    try_convert(const SightRead::Detail::Midi& midi) const;
 };
 }
 
@@ -0,0 +1,74 @@
+#ifndef SIGHTREAD_DETAIL_PARALLEL_HPP
+#define SIGHTREAD_DETAIL_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Resolves a max_threads option, where 0 means one thread per hardware thread.
+inline unsigned int thread_count(unsigned int max_threads)
+{
+    if (max_threads == 0) {
+        max_threads = std::thread::hardware_concurrency();
+    }
+    return std::max(max_threads, 1U);
+}
+
+// Returns {func(0), ..., func(count - 1)}, evaluated on up to max_threads
+// threads (see thread_count). func must be safe to call concurrently. If any
+// call throws, the exception from the lowest index is rethrown once every
+// thread has finished, so the outcome does not depend on scheduling.
+template <typename Func>
+std::vector<std::invoke_result_t<Func&, std::size_t>>
+parallel_map(std::size_t count, unsigned int max_threads, Func func)
+{
+    using Result = std::invoke_result_t<Func&, std::size_t>;
+
+    const auto threads
+        = std::min<std::size_t>(thread_count(max_threads), count);
+    std::vector<Result> results;
+    results.reserve(count);
+    if (threads <= 1) {
+        for (auto i = 0U; i < count; ++i) {
+            results.push_back(func(i));
+        }
+        return results;
+    }
+
+    std::vector<std::optional<Result>> slots(count);
+    std::vector<std::exception_ptr> errors(count);
+    std::atomic<std::size_t> next_index {0};
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(threads - 1);
+        const auto work = [&] {
+            for (auto i = next_index++; i < count; i = next_index++) {
+                try {
+                    slots[i].emplace(func(i));
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        };
+        for (auto i = 1U; i < threads; ++i) {
+            workers.emplace_back(work);
+        }
+        work();
+    }
+
+    for (auto i = 0U; i < count; ++i) {
+        if (errors[i] != nullptr) {
+            std::rethrow_exception(errors[i]);
+        }
+        results.push_back(std::move(*slots[i]));
+    }
+    return results;
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <array>
 #include <set>
+#include <utility>
 
 #include "sightread/detail/parserutil.hpp"
 
@@ -52,16 +53,18 @@ SightRead::Detail::combine_solo_events(
     return ranges;
 }
 
-std::vector<SightRead::Solo> SightRead::Detail::form_solo_vector(
+SightRead::ParseResult<std::vector<SightRead::Solo>>
+SightRead::Detail::form_solo_vector(
     const std::vector<int>& solo_on_events,
     const std::vector<int>& solo_off_events,
     const std::vector<SightRead::Note>& notes, SightRead::TrackType track_type,
-    SightRead::SoloParsingBehaviour solo_parsing_behaviour, bool is_midi)
+    SightRead::SoloParsingBehaviour solo_parsing_behaviour, bool is_midi,
+    const SightRead::Detail::LimitChecker& limit_checker)
 {
     constexpr int SOLO_NOTE_VALUE = 100;
 
     if (solo_parsing_behaviour == SightRead::SoloParsingBehaviour::NoSolos) {
-        return {};
+        return std::vector<SightRead::Solo> {};
     }
 
     auto ranges = combine_solo_events(solo_on_events, solo_off_events,
@@ -83,6 +86,9 @@ std::vector<SightRead::Solo> SightRead::Detail::form_solo_vector(
 
     std::vector<SightRead::Solo> solos;
     for (auto [start, end] : ranges) {
+        if (auto exceeded = limit_checker.check_time()) {
+            return std::move(*exceeded);
+        }
         std::set<SightRead::Tick> positions_in_solo;
         auto note_count = 0;
         for (const auto& note : notes) {
@@ -104,3 +110,29 @@ std::vector<SightRead::Solo> SightRead::Detail::form_solo_vector(
 
     return solos;
 }
+
+SightRead::ParseResult<SightRead::TempoMap> SightRead::Detail::try_tempo_map(
+    std::vector<SightRead::TimeSignature> time_sigs,
+    std::vector<SightRead::BPM> bpms, std::vector<SightRead::Tick> od_beats,
+    int resolution)
+{
+    const auto content_error = [](const char* message) {
+        return SightRead::ParseDiagnostic {
+            .category = SightRead::ParseErrorCategory::Content,
+            .byte_offset = std::nullopt,
+            .message = message};
+    };
+
+    for (const auto& bpm : bpms) {
+        if (bpm.millibeats_per_minute <= 0.0) {
+            return content_error("BPMs must be positive");
+        }
+    }
+    for (const auto& ts : time_sigs) {
+        if (ts.numerator <= 0 || ts.denominator <= 0) {
+            return content_error("Time signatures must be positive/positive");
+        }
+    }
+    return SightRead::TempoMap {std::move(time_sigs), std::move(bpms),
+                                std::move(od_beats), resolution};
+}
@@ -4,6 +4,8 @@
 #include <tuple>
 #include <vector>
 
+#include "sightread/detail/limitchecker.hpp"
+#include "sightread/parseresult.hpp"
 #include "sightread/soloparsingbehaviour.hpp"
 #include "sightread/songparts.hpp"
 #include "sightread/time.hpp"
@@ -19,11 +21,22 @@ combine_solo_events(const std::vector<int>& on_events,
                     const std::vector<int>& off_events,
                     SightRead::SoloParsingBehaviour solo_parsing_behaviour);
 
-std::vector<SightRead::Solo> form_solo_vector(
+// Takes time proportional to the number of solos times the number of notes,
+// so returns a diagnostic if limit_checker's time budget runs out partway
+// through.
+SightRead::ParseResult<std::vector<SightRead::Solo>> form_solo_vector(
     const std::vector<int>& solo_on_events,
     const std::vector<int>& solo_off_events,
     const std::vector<SightRead::Note>& notes, SightRead::TrackType track_type,
-    SightRead::SoloParsingBehaviour solo_parsing_behaviour, bool is_midi);
+    SightRead::SoloParsingBehaviour solo_parsing_behaviour, bool is_midi,
+    const SightRead::Detail::LimitChecker& limit_checker);
+
+// Like the TempoMap constructor, but returns a diagnostic instead of throwing
+// if a BPM or time signature is not positive.
+SightRead::ParseResult<SightRead::TempoMap>
+try_tempo_map(std::vector<SightRead::TimeSignature> time_sigs,
+              std::vector<SightRead::BPM> bpms,
+              std::vector<SightRead::Tick> od_beats, int resolution);
 }
 
 #endif
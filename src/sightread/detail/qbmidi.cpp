@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <optional>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 #include "sightread/detail/utils.hpp"
 #include "sightread/songparts.hpp"
@@ -6,7 +11,21 @@
 #include "qbmidi.hpp"
 
 namespace {
-[[nodiscard]] SightRead::Detail::QbItemType qb_item_type(std::uint8_t byte)
+// Files from the games nest arrays and structs only a few levels deep, so this
+// only stops files that point back at their own parents from exhausting the
+// stack.
+constexpr std::size_t MAX_NESTING_DEPTH = 64;
+
+SightRead::ParseDiagnostic syntax_error(std::size_t byte_offset,
+                                        std::string message)
+{
+    return {.category = SightRead::ParseErrorCategory::Syntax,
+            .byte_offset = byte_offset,
+            .message = std::move(message)};
+}
+
+[[nodiscard]] std::optional<SightRead::Detail::QbItemType>
+qb_item_type(std::uint8_t byte)
 {
     const std::unordered_map<int, SightRead::Detail::QbItemType>
         qb_type_mapping {{0, SightRead::Detail::QbItemType::StructFlag},
@@ -19,10 +38,15 @@ namespace {
                          {13, SightRead::Detail::QbItemType::QbKey},
                          {26, SightRead::Detail::QbItemType::Pointer}};
 
-    return qb_type_mapping.at(byte);
+    const auto iter = qb_type_mapping.find(byte);
+    if (iter == qb_type_mapping.end()) {
+        return std::nullopt;
+    }
+    return iter->second;
 }
 
-[[nodiscard]] SightRead::Detail::QbItemType ps2_qb_item_type(std::uint8_t byte)
+[[nodiscard]] std::optional<SightRead::Detail::QbItemType>
+ps2_qb_item_type(std::uint8_t byte)
 {
     const std::unordered_map<int, SightRead::Detail::QbItemType>
         ps2_qb_mapping {{3, SightRead::Detail::QbItemType::Integer},
@@ -32,168 +56,275 @@ namespace {
                         {27, SightRead::Detail::QbItemType::QbKey},
                         {53, SightRead::Detail::QbItemType::Pointer}};
 
-    return ps2_qb_mapping.at(byte);
+    const auto iter = ps2_qb_mapping.find(byte);
+    if (iter == ps2_qb_mapping.end()) {
+        return std::nullopt;
+    }
+    return iter->second;
 }
 
-class QbReader {
+// The byte order is a template parameter so that reads of scalars do not have
+// to branch on it. Every read reports a problem with the position in the file
+// the reader had reached.
+template <SightRead::Detail::Endianness endianness> class QbReader {
 private:
-    SightRead::Detail::Endianness m_endianness;
     std::span<const std::uint8_t> m_full_file;
     std::span<const std::uint8_t> m_remaining_data;
+    const SightRead::Detail::LimitChecker& m_limit_checker;
+    SightRead::Detail::QbMidi m_midi;
+    std::unordered_set<std::size_t> m_visited_offsets;
+    std::size_t m_event_count {0};
+
+    [[nodiscard]] std::size_t offset() const
+    {
+        return m_full_file.size() - m_remaining_data.size();
+    }
+
+    // Records that the item or node at the reader's position is being read.
+    // Their positions come from the file, so one reached a second time is
+    // part of a cycle and is rejected rather than read forever.
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic> visit()
+    {
+        if (!m_visited_offsets.insert(offset()).second) {
+            return syntax_error(offset(),
+                                "QB offset points to data already read");
+        }
+        return std::nullopt;
+    }
+
+    // Counts event_count more events towards the event limit, and checks the
+    // time budget. Items are few; the cost of a file is in the elements of its
+    // arrays and structs, such as notes, so those are counted too.
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic>
+    count_events(std::size_t event_count)
+    {
+        m_event_count += event_count;
+        if (auto exceeded = m_limit_checker.check_events(m_event_count)) {
+            return exceeded;
+        }
+        return m_limit_checker.check_time();
+    }
+
+    // Checks the node at the reader's position is not nested too deeply, and
+    // records it as visited.
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic>
+    visit_node(std::size_t depth)
+    {
+        if (depth > MAX_NESTING_DEPTH) {
+            return syntax_error(offset(), "QB nodes are nested too deeply");
+        }
+        return visit();
+    }
 
-    void advance_bytes(std::size_t byte_count)
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic>
+    advance_bytes(std::size_t byte_count)
     {
+        if (byte_count > m_remaining_data.size()) {
+            return insufficient_bytes(offset());
+        }
         m_remaining_data = m_remaining_data.subspan(byte_count);
+        return std::nullopt;
     }
 
     void snap_to_four_byte_alignment()
     {
-        const auto bytes_read = m_full_file.size() - m_remaining_data.size();
-        advance_bytes((~bytes_read + 1) & 0b11);
+        // Files need not be padded after their last item.
+        m_remaining_data = m_remaining_data.subspan(std::min<std::size_t>(
+            (~offset() + 1) & 0b11, m_remaining_data.size()));
     }
 
-    void move_to_position(std::size_t position)
+    [[nodiscard]] std::optional<SightRead::ParseDiagnostic>
+    move_to_position(std::size_t position)
     {
+        if (position > m_full_file.size()) {
+            return insufficient_bytes(offset());
+        }
         m_remaining_data = m_full_file.subspan(position);
+        return std::nullopt;
     }
 
-    float read_float()
+    template <typename T> SightRead::ParseResult<T> read_four_byte()
     {
-        float value = 0;
-        switch (m_endianness) {
-        case SightRead::Detail::Endianness::BigEndian:
-            value = read_four_byte_be<float>(m_remaining_data, 0);
-            break;
-        case SightRead::Detail::Endianness::LittleEndian:
-            value = read_four_byte_le<float>(m_remaining_data, 0);
-            break;
+        if (m_remaining_data.size() < 4) {
+            return insufficient_bytes(offset());
+        }
+        T value = 0;
+        if constexpr (endianness == SightRead::Detail::Endianness::BigEndian) {
+            value = read_four_byte_be<T>(m_remaining_data, 0);
+        } else {
+            value = read_four_byte_le<T>(m_remaining_data, 0);
         }
-        advance_bytes(4);
+        m_remaining_data = m_remaining_data.subspan(4);
         return value;
     }
 
-    std::int32_t read_int32()
+    SightRead::ParseResult<float> read_float()
     {
-        std::int32_t value = 0;
-        switch (m_endianness) {
-        case SightRead::Detail::Endianness::BigEndian:
-            value = read_four_byte_be<std::int32_t>(m_remaining_data, 0);
-            break;
-        case SightRead::Detail::Endianness::LittleEndian:
-            value = read_four_byte_le<std::int32_t>(m_remaining_data, 0);
-            break;
-        }
-        advance_bytes(4);
-        return value;
+        return read_four_byte<float>();
     }
 
-    std::uint32_t read_le_uint32()
+    SightRead::ParseResult<std::int32_t> read_int32()
     {
+        return read_four_byte<std::int32_t>();
+    }
+
+    SightRead::ParseResult<std::uint32_t> read_le_uint32()
+    {
+        if (m_remaining_data.size() < 4) {
+            return insufficient_bytes(offset());
+        }
         const auto value
             = read_four_byte_le<std::uint32_t>(m_remaining_data, 0);
-        advance_bytes(4);
+        m_remaining_data = m_remaining_data.subspan(4);
         return value;
     }
 
-    std::uint32_t read_uint32()
+    SightRead::ParseResult<std::uint32_t> read_uint32()
     {
-        std::uint32_t value = 0;
-        switch (m_endianness) {
-        case SightRead::Detail::Endianness::BigEndian:
-            value = read_four_byte_be<std::uint32_t>(m_remaining_data, 0);
-            break;
-        case SightRead::Detail::Endianness::LittleEndian:
-            value = read_four_byte_le<std::uint32_t>(m_remaining_data, 0);
-            break;
-        }
-        advance_bytes(4);
-        return value;
+        return read_four_byte<std::uint32_t>();
     }
 
-    std::uint16_t read_uint16()
+    SightRead::ParseResult<std::uint16_t> read_uint16()
     {
+        if (m_remaining_data.size() < 2) {
+            return insufficient_bytes(offset());
+        }
         std::uint16_t value = 0;
-        switch (m_endianness) {
-        case SightRead::Detail::Endianness::BigEndian:
+        if constexpr (endianness == SightRead::Detail::Endianness::BigEndian) {
             value = read_two_byte_be<std::uint16_t>(m_remaining_data, 0);
-            break;
-        case SightRead::Detail::Endianness::LittleEndian:
+        } else {
             value = read_two_byte_le<std::uint16_t>(m_remaining_data, 0);
-            break;
         }
-        advance_bytes(2);
+        m_remaining_data = m_remaining_data.subspan(2);
         return value;
     }
 
-    char read_char() { return static_cast<char>(pop_front(m_remaining_data)); }
+    SightRead::ParseResult<char> read_char()
+    {
+        if (m_remaining_data.empty()) {
+            return insufficient_bytes(offset());
+        }
+        return static_cast<char>(pop_front(m_remaining_data));
+    }
 
-    [[nodiscard]] SightRead::Detail::QbItemType
+    [[nodiscard]] std::optional<SightRead::Detail::QbItemType>
     struct_item_type(std::uint8_t byte) const
     {
-        if (m_endianness == SightRead::Detail::Endianness::LittleEndian) {
+        if constexpr (endianness
+                      == SightRead::Detail::Endianness::LittleEndian) {
             return ps2_qb_item_type(byte);
         }
 
         return qb_item_type(byte);
     }
 
-    std::vector<std::any> read_array_node()
+    // Reads the arrays or structs starting at the offsets at the reader's
+    // position, returning their indices.
+    template <typename ReadNode>
+    SightRead::ParseResult<std::vector<std::size_t>>
+    read_nodes(std::uint32_t item_count, ReadNode read_node)
+    {
+        const auto list_start = read_uint32();
+        if (!list_start) {
+            return list_start.error();
+        }
+        if (auto error = move_to_position(*list_start)) {
+            return std::move(*error);
+        }
+        std::vector<std::uint32_t> start_list;
+        if (item_count == 1) {
+            start_list.push_back(*list_start);
+        } else {
+            for (auto i = 0U; i < item_count; ++i) {
+                const auto start = read_uint32();
+                if (!start) {
+                    return start.error();
+                }
+                start_list.push_back(*start);
+            }
+        }
+
+        std::vector<std::size_t> nodes;
+        nodes.reserve(start_list.size());
+        for (auto start : start_list) {
+            if (auto error = move_to_position(start)) {
+                return std::move(*error);
+            }
+            const auto node = read_node();
+            if (!node) {
+                return node.error();
+            }
+            nodes.push_back(node->index);
+        }
+        return nodes;
+    }
+
+    SightRead::ParseResult<SightRead::Detail::QbArrayRef>
+    read_array_node(std::size_t depth)
     {
+        if (auto error = visit_node(depth)) {
+            return std::move(*error);
+        }
         const auto first_item = read_item_info();
+        if (!first_item) {
+            return first_item.error();
+        }
         const auto item_count = read_uint32();
-        std::vector<std::any> array;
-        array.reserve(item_count);
+        if (!item_count) {
+            return item_count.error();
+        }
+        SightRead::Detail::QbArray array {
+            .element_type = first_item->type, .first = 0, .size = 0};
 
-        switch (first_item.type) {
+        switch (first_item->type) {
         case SightRead::Detail::QbItemType::StructFlag:
-            advance_bytes(4);
+            if (auto error = advance_bytes(4)) {
+                return std::move(*error);
+            }
             break;
         case SightRead::Detail::QbItemType::Integer: {
-            if (item_count > 1) {
+            if (*item_count > 1) {
                 const auto list_start = read_uint32();
-                move_to_position(list_start);
-            }
-            for (auto i = 0U; i < item_count; ++i) {
-                array.emplace_back(read_uint32());
-            }
-            break;
-        }
-        case SightRead::Detail::QbItemType::Struct: {
-            const auto list_start = read_uint32();
-            move_to_position(list_start);
-            std::vector<std::uint32_t> start_list;
-            if (item_count == 1) {
-                start_list.push_back(list_start);
-            } else {
-                for (auto i = 0U; i < item_count; ++i) {
-                    start_list.push_back(read_uint32());
+                if (!list_start) {
+                    return list_start.error();
+                }
+                if (auto error = move_to_position(*list_start)) {
+                    return std::move(*error);
                 }
             }
-
-            for (auto start : start_list) {
-                move_to_position(start);
-                array.emplace_back(read_struct_data());
+            // The integers are left in the file and decoded as they are used.
+            if (m_remaining_data.size() / 4 < *item_count) {
+                return insufficient_bytes(offset());
             }
-
+            if (auto exceeded = count_events(*item_count)) {
+                return std::move(*exceeded);
+            }
+            array.first = offset();
+            array.size = *item_count;
+            m_remaining_data = m_remaining_data.subspan(
+                4 * static_cast<std::size_t>(*item_count));
             break;
         }
+        case SightRead::Detail::QbItemType::Struct:
         case SightRead::Detail::QbItemType::Array: {
-            const auto list_start = read_uint32();
-            move_to_position(list_start);
-            std::vector<std::uint32_t> start_list;
-            if (item_count == 1) {
-                start_list.push_back(list_start);
-            } else {
-                for (auto i = 0U; i < item_count; ++i) {
-                    start_list.push_back(read_uint32());
-                }
+            if (auto exceeded = count_events(*item_count)) {
+                return std::move(*exceeded);
             }
-
-            for (auto start : start_list) {
-                move_to_position(start);
-                array.emplace_back(read_array_node());
+            // Nested nodes are read before any of the elements are stored, so
+            // that the elements are contiguous in node_elements.
+            const auto nodes
+                = first_item->type == SightRead::Detail::QbItemType::Struct
+                ? read_nodes(*item_count,
+                             [&] { return read_struct_data(depth + 1); })
+                : read_nodes(*item_count,
+                             [&] { return read_array_node(depth + 1); });
+            if (!nodes) {
+                return nodes.error();
             }
-
+            array.first = m_midi.node_elements.size();
+            array.size = nodes->size();
+            m_midi.node_elements.insert(m_midi.node_elements.end(),
+                                        nodes->cbegin(), nodes->cend());
             break;
         }
         case SightRead::Detail::QbItemType::Float:
@@ -202,52 +333,98 @@ private:
         case SightRead::Detail::QbItemType::String:
         case SightRead::Detail::QbItemType::WideString:
         default:
-            throw SightRead::ParseError(
+            return syntax_error(
+                offset(),
                 "Unexpected type for array element, "
-                + std::to_string(static_cast<int>(first_item.type)));
+                    + std::to_string(static_cast<int>(first_item->type)));
         }
 
-        return array;
+        m_midi.array_nodes.push_back(array);
+        return SightRead::Detail::QbArrayRef {.index
+                                              = m_midi.array_nodes.size() - 1};
     }
 
-    SightRead::Detail::QbHeader read_header()
+    SightRead::ParseResult<SightRead::Detail::QbHeader> read_header()
     {
         constexpr auto REST_OF_HEADER_SIZE = 20;
 
         const auto flags = read_uint32();
+        if (!flags) {
+            return flags.error();
+        }
         const auto file_size = read_uint32();
-        advance_bytes(REST_OF_HEADER_SIZE);
-        return {.flags = flags, .file_size = file_size};
+        if (!file_size) {
+            return file_size.error();
+        }
+        if (auto error = advance_bytes(REST_OF_HEADER_SIZE)) {
+            return std::move(*error);
+        }
+        return SightRead::Detail::QbHeader {.flags = *flags,
+                                            .file_size = *file_size};
     }
 
-    SightRead::Detail::QbItem read_item()
+    SightRead::ParseResult<SightRead::Detail::QbItem> read_item()
     {
+        if (auto error = visit()) {
+            return std::move(*error);
+        }
+        if (auto exceeded = count_events(1)) {
+            return std::move(*exceeded);
+        }
         const auto info = read_item_info();
-        const auto shared_props = read_shared_props(info.type);
-        const auto data_value = read_value(info.type, shared_props.value);
-        return {.info = info, .props = shared_props, .data = data_value};
+        if (!info) {
+            return info.error();
+        }
+        const auto shared_props = read_shared_props(info->type);
+        if (!shared_props) {
+            return shared_props.error();
+        }
+        auto data_value = read_value(info->type, shared_props->value, 0);
+        if (!data_value) {
+            return std::move(data_value.error());
+        }
+        return SightRead::Detail::QbItem {
+            .info = *info, .props = *shared_props, .data = *data_value};
     }
 
-    SightRead::Detail::QbItemInfo read_item_info()
+    SightRead::ParseResult<SightRead::Detail::QbItemInfo> read_item_info()
     {
+        const auto position = offset();
         const auto info = read_le_uint32();
-        const auto flags = static_cast<std::uint8_t>(info >> 8);
-        const auto type = qb_item_type((info >> 16) & 0x7F);
-        return {.flags = flags, .type = type};
+        if (!info) {
+            return info.error();
+        }
+        const auto flags = static_cast<std::uint8_t>(*info >> 8);
+        const auto type = qb_item_type((*info >> 16) & 0x7F);
+        if (!type.has_value()) {
+            return syntax_error(position, "Unknown QB item type");
+        }
+        return SightRead::Detail::QbItemInfo {.flags = flags, .type = *type};
     }
 
-    SightRead::Detail::QbSharedProps
+    SightRead::ParseResult<SightRead::Detail::QbSharedProps>
     read_shared_props(SightRead::Detail::QbItemType type)
     {
         const auto id = read_uint32();
+        if (!id) {
+            return id.error();
+        }
         const auto qb_name = read_uint32();
+        if (!qb_name) {
+            return qb_name.error();
+        }
 
         SightRead::Detail::QbSharedProps props {
-            .id = id, .qb_name = qb_name, .value = {}};
+            .id = *id, .qb_name = *qb_name, .value = {}};
         switch (type) {
-        case SightRead::Detail::QbItemType::Array:
-            props.value = read_uint32();
+        case SightRead::Detail::QbItemType::Array: {
+            const auto value = read_uint32();
+            if (!value) {
+                return value.error();
+            }
+            props.value = *value;
             break;
+        }
         case SightRead::Detail::QbItemType::Float:
         case SightRead::Detail::QbItemType::Integer:
         case SightRead::Detail::QbItemType::Pointer:
@@ -257,167 +434,262 @@ private:
         case SightRead::Detail::QbItemType::StructFlag:
         case SightRead::Detail::QbItemType::WideString:
         default:
-            throw SightRead::ParseError(
-                "Unexpected type for QbSharedProps, "
-                + std::to_string(static_cast<int>(type)));
+            return syntax_error(offset(),
+                                "Unexpected type for QbSharedProps, "
+                                    + std::to_string(static_cast<int>(type)));
         }
 
-        advance_bytes(4);
+        if (auto error = advance_bytes(4)) {
+            return std::move(*error);
+        }
         return props;
     }
 
-    std::any read_simple_value(SightRead::Detail::QbItemType type)
+    SightRead::ParseResult<SightRead::Detail::QbValue>
+    read_simple_value(SightRead::Detail::QbItemType type)
     {
         switch (type) {
         case SightRead::Detail::QbItemType::Integer:
-            return read_int32();
+            return to_value(read_int32());
         case SightRead::Detail::QbItemType::Float:
-            return read_float();
+            return to_value(read_float());
         case SightRead::Detail::QbItemType::Pointer:
         case SightRead::Detail::QbItemType::QbKey:
         case SightRead::Detail::QbItemType::String:
         case SightRead::Detail::QbItemType::Struct:
         case SightRead::Detail::QbItemType::WideString:
-            return read_uint32();
+            return to_value(read_uint32());
         case SightRead::Detail::QbItemType::Array:
         case SightRead::Detail::QbItemType::StructFlag:
         default:
-            throw SightRead::ParseError(
-                "Need to read simple "
-                + std::to_string(static_cast<int>(type)));
+            return syntax_error(offset(),
+                                "Need to read simple "
+                                    + std::to_string(static_cast<int>(type)));
         }
     }
 
-    std::string read_string()
+    SightRead::ParseResult<SightRead::Detail::QbStringRef> read_string()
     {
-        std::string value;
+        auto& value = m_midi.strings.emplace_back();
 
         while (true) {
             const auto character = read_char();
-            if (character == 0) {
-                return value;
+            if (!character) {
+                return character.error();
             }
-            value.push_back(character);
+            if (*character == 0) {
+                return SightRead::Detail::QbStringRef {
+                    .index = m_midi.strings.size() - 1};
+            }
+            value.push_back(*character);
         }
     }
 
-    SightRead::Detail::QbStructData read_struct_data()
+    SightRead::ParseResult<SightRead::Detail::QbStructRef>
+    read_struct_data(std::size_t depth)
     {
+        if (auto error = visit_node(depth)) {
+            return std::move(*error);
+        }
         const auto header_marker = read_uint32();
+        if (!header_marker) {
+            return header_marker.error();
+        }
         const auto item_offset = read_uint32();
+        if (!item_offset) {
+            return item_offset.error();
+        }
+        // Items can contain structs of their own, so they are only stored
+        // once they have all been read to keep them contiguous.
         std::vector<SightRead::Detail::QbStructItem> items;
-        auto next_item = item_offset;
+        auto next_item = *item_offset;
 
         while (next_item != 0) {
-            move_to_position(next_item);
-            items.push_back(read_struct_item());
+            if (auto error = move_to_position(next_item)) {
+                return std::move(*error);
+            }
+            auto item = read_struct_item(depth);
+            if (!item) {
+                return std::move(item.error());
+            }
+            items.push_back(std::move(*item));
             next_item = items.back().props.next_item;
         }
 
-        return {.header_marker = header_marker,
-                .item_offset = item_offset,
-                .items = std::move(items)};
+        m_midi.struct_nodes.push_back(
+            {.header_marker = *header_marker,
+             .item_offset = *item_offset,
+             .first_item = m_midi.struct_items.size(),
+             .item_count = items.size()});
+        m_midi.struct_items.insert(m_midi.struct_items.end(), items.cbegin(),
+                                   items.cend());
+        return SightRead::Detail::QbStructRef {
+            .index = m_midi.struct_nodes.size() - 1};
     }
 
-    SightRead::Detail::QbStructInfo read_struct_info()
+    SightRead::ParseResult<SightRead::Detail::QbStructInfo> read_struct_info()
     {
+        const auto position = offset();
         const auto info = read_le_uint32();
-        const auto flags = static_cast<std::uint8_t>(info >> 8);
+        if (!info) {
+            return info.error();
+        }
+        const auto flags = static_cast<std::uint8_t>(*info >> 8);
         auto info_byte = flags;
-        const auto info_byte_2 = static_cast<std::uint8_t>(info >> 16);
+        const auto info_byte_2 = static_cast<std::uint8_t>(*info >> 16);
         if (info_byte == 1 && info_byte_2 != 0) {
             info_byte = info_byte_2;
         }
         const auto type = struct_item_type(info_byte & 0x7F);
-        return {.flags = flags, .type = type};
+        if (!type.has_value()) {
+            return syntax_error(position, "Unknown QB item type");
+        }
+        return SightRead::Detail::QbStructInfo {.flags = flags, .type = *type};
     }
 
-    SightRead::Detail::QbStructItem read_struct_item()
+    SightRead::ParseResult<SightRead::Detail::QbStructItem>
+    read_struct_item(std::size_t depth)
     {
+        if (auto error = visit()) {
+            return std::move(*error);
+        }
+        if (auto exceeded = count_events(1)) {
+            return std::move(*exceeded);
+        }
         const auto info = read_struct_info();
-        const auto props = read_struct_props(info.type);
-        const auto data_value = read_value(info.type, props.value);
+        if (!info) {
+            return info.error();
+        }
+        const auto props = read_struct_props(info->type);
+        if (!props) {
+            return props.error();
+        }
+        auto data_value = read_value(info->type, props->value, depth + 1);
+        if (!data_value) {
+            return std::move(data_value.error());
+        }
 
-        return {.info = info, .props = props, .data = data_value};
+        return SightRead::Detail::QbStructItem {
+            .info = *info, .props = *props, .data = *data_value};
     }
 
-    SightRead::Detail::QbStructProps
+    SightRead::ParseResult<SightRead::Detail::QbStructProps>
     read_struct_props(SightRead::Detail::QbItemType type)
     {
         const auto id = read_uint32();
+        if (!id) {
+            return id.error();
+        }
         const auto value = read_simple_value(type);
+        if (!value) {
+            return value.error();
+        }
         const auto next_item = read_uint32();
-        return {.id = id, .value = value, .next_item = next_item};
+        if (!next_item) {
+            return next_item.error();
+        }
+        return SightRead::Detail::QbStructProps {
+            .id = *id, .value = *value, .next_item = *next_item};
     }
 
-    std::any read_value(SightRead::Detail::QbItemType type,
-                        const std::any& default_value)
+    SightRead::ParseResult<SightRead::Detail::QbValue>
+    read_value(SightRead::Detail::QbItemType type,
+               const SightRead::Detail::QbValue& default_value,
+               std::size_t depth)
     {
-        std::any value;
+        SightRead::ParseResult<SightRead::Detail::QbValue> value
+            = default_value;
 
         switch (type) {
         case SightRead::Detail::QbItemType::Float:
         case SightRead::Detail::QbItemType::Integer:
         case SightRead::Detail::QbItemType::Pointer:
         case SightRead::Detail::QbItemType::QbKey:
-            value = default_value;
             break;
         case SightRead::Detail::QbItemType::Array:
-            value = read_array_node();
+            value = to_value(read_array_node(depth));
             break;
         case SightRead::Detail::QbItemType::String:
-            value = read_string();
+            value = to_value(read_string());
             break;
         case SightRead::Detail::QbItemType::Struct:
-            value = read_struct_data();
+            value = to_value(read_struct_data(depth));
             break;
         case SightRead::Detail::QbItemType::WideString:
-            value = read_widestring();
+            value = to_value(read_widestring());
             break;
         case SightRead::Detail::QbItemType::StructFlag:
         default:
-            throw SightRead::ParseError(
-                "Unexpected type for Qb value, "
-                + std::to_string(static_cast<int>(type)));
+            return syntax_error(offset(),
+                                "Unexpected type for Qb value, "
+                                    + std::to_string(static_cast<int>(type)));
         }
 
-        snap_to_four_byte_alignment();
+        if (value) {
+            snap_to_four_byte_alignment();
+        }
 
         return value;
     }
 
-    std::wstring read_widestring()
+    SightRead::ParseResult<SightRead::Detail::QbWideStringRef>
+    read_widestring()
     {
-        std::wstring value;
+        auto& value = m_midi.wide_strings.emplace_back();
 
         while (true) {
             const auto character = read_uint16();
-            if (character == 0) {
-                return value;
+            if (!character) {
+                return character.error();
             }
-            value.push_back(character);
+            if (*character == 0) {
+                return SightRead::Detail::QbWideStringRef {
+                    .index = m_midi.wide_strings.size() - 1};
+            }
+            value.push_back(*character);
         }
     }
 
+    template <typename T>
+    static SightRead::ParseResult<SightRead::Detail::QbValue>
+    to_value(const SightRead::ParseResult<T>& result)
+    {
+        if (!result) {
+            return result.error();
+        }
+        return SightRead::Detail::QbValue {*result};
+    }
+
 public:
     QbReader(std::span<const std::uint8_t> file,
-             SightRead::Detail::Endianness endianness)
-        : m_endianness {endianness}
-        , m_full_file {file}
+             const SightRead::Detail::LimitChecker& limit_checker)
+        : m_full_file {file}
         , m_remaining_data {file}
+        , m_limit_checker {limit_checker}
     {
     }
 
-    SightRead::Detail::QbMidi parse()
+    SightRead::ParseResult<SightRead::Detail::QbMidi> parse() &&
     {
+        m_midi.data = m_full_file;
+        m_midi.endianness = endianness;
         const auto header = read_header();
-        std::vector<SightRead::Detail::QbItem> items;
+        if (!header) {
+            return header.error();
+        }
+        m_midi.header = *header;
 
         while (!m_remaining_data.empty()) {
-            items.push_back(read_item());
+            auto item = read_item();
+            if (!item) {
+                return std::move(item.error());
+            }
+            m_midi.items.push_back(std::move(*item));
+            m_midi.item_index.try_emplace(m_midi.items.back().props.id,
+                                          m_midi.items.size() - 1);
         }
 
-        return {.header = header, .items = items};
+        return std::move(m_midi);
     }
 };
 }
@@ -426,6 +698,99 @@ SightRead::Detail::QbMidi
 SightRead::Detail::parse_qb(std::span<const std::uint8_t> data,
                             Endianness endianness)
 {
-    QbReader reader {data, endianness};
-    return reader.parse();
+    return try_parse_qb(data, endianness).value();
+}
+
+SightRead::ParseResult<SightRead::Detail::QbMidi>
+SightRead::Detail::try_parse_qb(std::span<const std::uint8_t> data,
+                                Endianness endianness)
+{
+    return try_parse_qb(data, endianness,
+                        LimitChecker {SightRead::ParseLimits {}});
+}
+
+SightRead::ParseResult<SightRead::Detail::QbMidi>
+SightRead::Detail::try_parse_qb(std::span<const std::uint8_t> data,
+                                Endianness endianness,
+                                const LimitChecker& limit_checker)
+{
+    if (endianness == Endianness::LittleEndian) {
+        return QbReader<Endianness::LittleEndian> {data, limit_checker}
+            .parse();
+    }
+
+    return QbReader<Endianness::BigEndian> {data, limit_checker}.parse();
+}
+
+const SightRead::Detail::QbItem*
+SightRead::Detail::QbMidi::item_by_id(std::uint32_t id) const
+{
+    const auto iter = item_index.find(id);
+    if (iter == item_index.end()) {
+        return nullptr;
+    }
+    return &items[iter->second];
+}
+
+const SightRead::Detail::QbArray*
+SightRead::Detail::QbMidi::array(const QbValue& value) const
+{
+    const auto* ref = std::get_if<QbArrayRef>(&value);
+    if (ref == nullptr) {
+        return nullptr;
+    }
+    return &array_nodes.at(ref->index);
+}
+
+std::optional<SightRead::Detail::QbIntegers>
+SightRead::Detail::QbMidi::integers(const QbArray& array) const
+{
+    if (array.size == 0) {
+        return QbIntegers {};
+    }
+    if (array.element_type != QbItemType::Integer) {
+        return std::nullopt;
+    }
+    const auto bytes = data.subspan(array.first, 4 * array.size);
+    if (endianness == Endianness::BigEndian) {
+        return QbIntegerView<Endianness::BigEndian> {bytes};
+    }
+    return QbIntegerView<Endianness::LittleEndian> {bytes};
+}
+
+const SightRead::Detail::QbArray*
+SightRead::Detail::QbMidi::array_element(const QbArray& array,
+                                         std::size_t index) const
+{
+    if (array.element_type != QbItemType::Array || index >= array.size) {
+        return nullptr;
+    }
+    return &array_nodes.at(node_elements.at(array.first + index));
+}
+
+const SightRead::Detail::QbStructData*
+SightRead::Detail::QbMidi::struct_element(const QbArray& array,
+                                          std::size_t index) const
+{
+    if (array.element_type != QbItemType::Struct || index >= array.size) {
+        return nullptr;
+    }
+    return &struct_nodes.at(node_elements.at(array.first + index));
+}
+
+std::span<const SightRead::Detail::QbStructItem>
+SightRead::Detail::QbMidi::items_of(const QbStructData& struct_data) const
+{
+    return std::span {struct_items}.subspan(struct_data.first_item,
+                                            struct_data.item_count);
+}
+
+const std::u16string*
+SightRead::Detail::QbMidi::wide_string(const QbValue& value) const
+{
+    const auto* ref = std::get_if<QbWideStringRef>(&value);
+    if (ref == nullptr) {
+        return nullptr;
+    }
+    return &wide_strings.at(ref->index);
 }
@@ -1,11 +1,20 @@
 #ifndef SIGHTREAD_DETAIL_QBMIDI_HPP
 #define SIGHTREAD_DETAIL_QBMIDI_HPP
 
-#include <any>
+#include <climits>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
+#include <optional>
 #include <span>
+#include <string>
+#include <unordered_map>
+#include <variant>
 #include <vector>
 
+#include "sightread/detail/limitchecker.hpp"
+#include "sightread/parseresult.hpp"
+
 namespace SightRead::Detail {
 struct QbHeader {
     std::uint32_t flags;
@@ -24,6 +33,41 @@ enum class QbItemType : std::uint8_t {
     WideString
 };
 
+// Arrays, structs and strings are stored in the QbMidi they were read into
+// and referred to by their index there.
+struct QbArrayRef {
+    std::size_t index;
+};
+
+struct QbStructRef {
+    std::size_t index;
+};
+
+struct QbStringRef {
+    std::size_t index;
+};
+
+struct QbWideStringRef {
+    std::size_t index;
+};
+
+// Integers are signed when they are Integer values and unsigned when they are
+// array lengths, pointers, keys, or the elements of integer arrays.
+using QbValue = std::variant<std::monostate, std::int32_t, std::uint32_t,
+                             float, QbArrayRef, QbStructRef, QbStringRef,
+                             QbWideStringRef>;
+
+// Returns the T in value, or std::nullopt if it holds a value of another
+// type.
+template <typename T> std::optional<T> qb_value_as(const QbValue& value)
+{
+    const auto* result = std::get_if<T>(&value);
+    if (result == nullptr) {
+        return std::nullopt;
+    }
+    return *result;
+}
+
 struct QbItemInfo {
     std::uint8_t flags;
     QbItemType type;
@@ -32,18 +76,24 @@ struct QbItemInfo {
 struct QbSharedProps {
     std::uint32_t id;
     std::uint32_t qb_name;
-    std::any value;
+    QbValue value;
 };
 
 struct QbItem {
     QbItemInfo info;
     QbSharedProps props;
-    std::any data;
+    QbValue data;
 };
 
-struct QbMidi {
-    QbHeader header;
-    std::vector<QbItem> items;
+// The elements of an array all have element_type. Integer arrays are the size
+// four byte integers starting at byte first of the parsed data. Arrays of
+// arrays or structs are the range [first, first + size) of
+// QbMidi::node_elements, which holds indices into QbMidi::array_nodes or
+// QbMidi::struct_nodes.
+struct QbArray {
+    QbItemType element_type;
+    std::size_t first;
+    std::size_t size;
 };
 
 struct QbStructInfo {
@@ -53,25 +103,158 @@ struct QbStructInfo {
 
 struct QbStructProps {
     std::uint32_t id;
-    std::any value;
+    QbValue value;
     std::uint32_t next_item;
 };
 
 struct QbStructItem {
     QbStructInfo info;
     QbStructProps props;
-    std::any data;
+    QbValue data;
 };
 
+// The items of a struct are the range [first_item, first_item + item_count)
+// of QbMidi::struct_items.
 struct QbStructData {
     std::uint32_t header_marker;
     std::uint32_t item_offset;
-    std::vector<QbStructItem> items;
+    std::size_t first_item;
+    std::size_t item_count;
 };
 
 enum class Endianness { LittleEndian, BigEndian };
 
+// The unsigned four byte integers stored in bytes with the given endianness,
+// decoded as they are read. The endianness is a template parameter so that
+// reading an element does not branch on it. The viewed bytes must outlive the
+// view.
+template <Endianness endianness> class QbIntegerView {
+private:
+    std::span<const std::uint8_t> m_bytes;
+
+public:
+    class Iterator {
+    private:
+        const QbIntegerView* m_view {nullptr};
+        std::size_t m_index {0};
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using iterator_concept = std::forward_iterator_tag;
+        using value_type = std::uint32_t;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        Iterator(const QbIntegerView* view, std::size_t index)
+            : m_view {view}
+            , m_index {index}
+        {
+        }
+
+        std::uint32_t operator*() const { return (*m_view)[m_index]; }
+
+        Iterator& operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            auto copy = *this;
+            ++m_index;
+            return copy;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return m_index == other.m_index;
+        }
+    };
+
+    QbIntegerView() = default;
+    explicit QbIntegerView(std::span<const std::uint8_t> bytes)
+        : m_bytes {bytes}
+    {
+    }
+
+    [[nodiscard]] std::size_t size() const { return m_bytes.size() / 4; }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    [[nodiscard]] std::uint32_t operator[](std::size_t index) const
+    {
+        const auto bytes = m_bytes.subspan(4 * index, 4);
+        if constexpr (endianness == Endianness::BigEndian) {
+            return static_cast<std::uint32_t>(bytes[0]) << (3 * CHAR_BIT)
+                | static_cast<std::uint32_t>(bytes[1]) << (2 * CHAR_BIT)
+                | static_cast<std::uint32_t>(bytes[2]) << CHAR_BIT
+                | static_cast<std::uint32_t>(bytes[3]);
+        } else {
+            return static_cast<std::uint32_t>(bytes[0])
+                | static_cast<std::uint32_t>(bytes[1]) << CHAR_BIT
+                | static_cast<std::uint32_t>(bytes[2]) << (2 * CHAR_BIT)
+                | static_cast<std::uint32_t>(bytes[3]) << (3 * CHAR_BIT);
+        }
+    }
+
+    [[nodiscard]] Iterator begin() const { return {this, 0}; }
+    [[nodiscard]] Iterator end() const { return {this, size()}; }
+};
+
+// An integer array in whichever endianness its file uses. Visiting it picks the
+// decoder once for the whole array.
+using QbIntegers = std::variant<QbIntegerView<Endianness::LittleEndian>,
+                                QbIntegerView<Endianness::BigEndian>>;
+
+// A parsed .mid.qb file. The nodes and text its items refer to are held in one
+// flat array per type rather than allocated individually. Integer arrays such
+// as note data are not copied out of the parsed data, so it must outlive the
+// QbMidi.
+struct QbMidi {
+    QbHeader header;
+    std::span<const std::uint8_t> data;
+    Endianness endianness {Endianness::LittleEndian};
+    std::vector<QbItem> items;
+    std::vector<std::size_t> node_elements;
+    std::vector<QbArray> array_nodes;
+    std::vector<QbStructData> struct_nodes;
+    std::vector<QbStructItem> struct_items;
+    std::vector<std::string> strings;
+    std::vector<std::u16string> wide_strings;
+    // Maps an item's id to its position in items. Where ids are repeated the
+    // first item with the id is used.
+    std::unordered_map<std::uint32_t, std::size_t> item_index;
+
+    // Returns nullptr if there is no item with the id.
+    [[nodiscard]] const QbItem* item_by_id(std::uint32_t id) const;
+
+    // These return nullptr or std::nullopt if the value or array does not
+    // hold what is asked for, so that callers can say what they expected.
+    [[nodiscard]] const QbArray* array(const QbValue& value) const;
+    [[nodiscard]] std::optional<QbIntegers> integers(const QbArray& array) const;
+    [[nodiscard]] const QbArray* array_element(const QbArray& array,
+                                               std::size_t index) const;
+    [[nodiscard]] const QbStructData* struct_element(const QbArray& array,
+                                                     std::size_t index) const;
+    [[nodiscard]] std::span<const QbStructItem>
+    items_of(const QbStructData& struct_data) const;
+    [[nodiscard]] const std::u16string* wide_string(const QbValue& value) const;
+};
+
+// Throws SightRead::ParseError if data is not a valid QB file.
 QbMidi parse_qb(std::span<const std::uint8_t> data, Endianness endianness);
+
+// Like parse_qb, but returns a diagnostic with the position of the problem
+// instead of throwing.
+SightRead::ParseResult<QbMidi> try_parse_qb(std::span<const std::uint8_t> data,
+                                            Endianness endianness);
+
+// As above, but reading stops with a LimitExceeded diagnostic as soon as the
+// items, struct items and array elements read so far exceed limit_checker's
+// event limit, or its time budget runs out.
+SightRead::ParseResult<QbMidi>
+try_parse_qb(std::span<const std::uint8_t> data, Endianness endianness,
+             const SightRead::Detail::LimitChecker& limit_checker);
 }
 
 #endif
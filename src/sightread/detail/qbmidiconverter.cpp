@@ -3,11 +3,14 @@
 #include <cassert>
 #include <climits>
 #include <optional>
+#include <span>
+#include <string>
 #include <unordered_map>
+#include <variant>
 
-#include <boost/locale.hpp>
-
+#include "sightread/detail/parserutil.hpp"
 #include "sightread/detail/qbmidiconverter.hpp"
+#include "sightread/detail/stringutil.hpp"
 
 namespace {
 constexpr int RESOLUTION = 19200;
@@ -2990,34 +2993,88 @@ std::string section_name_from_pointer(std::uint32_t pointer)
     return iter->second;
 }
 
-SightRead::Detail::QbItem
-find_item_by_id(const std::vector<SightRead::Detail::QbItem>& items,
-                std::string_view suffix, std::uint32_t prefix_crc)
+SightRead::ParseDiagnostic content_error(const char* message)
 {
-    const auto crc = crc32(suffix, prefix_crc);
+    return {.category = SightRead::ParseErrorCategory::Content,
+            .byte_offset = std::nullopt,
+            .message = message};
+}
 
-    for (const auto& item : items) {
-        if (item.props.id == crc) {
-            return item;
-        }
+// Returns the array held by the item whose id is the CRC of suffix continued
+// from prefix_crc.
+SightRead::ParseResult<const SightRead::Detail::QbArray*>
+find_array_by_id(const SightRead::Detail::QbMidi& midi,
+                 std::string_view suffix, std::uint32_t prefix_crc)
+{
+    const auto* item = midi.item_by_id(crc32(suffix, prefix_crc));
+    if (item == nullptr) {
+        return content_error("Unable to find item by id");
+    }
+    const auto* array = midi.array(item->data);
+    if (array == nullptr) {
+        return content_error("Unexpected QB value type");
     }
+    return array;
+}
 
-    throw SightRead::ParseError("Unable to find item by id");
+SightRead::ParseResult<SightRead::Detail::QbIntegers>
+find_integers_by_id(const SightRead::Detail::QbMidi& midi,
+                    std::string_view suffix, std::uint32_t prefix_crc)
+{
+    const auto array = find_array_by_id(midi, suffix, prefix_crc);
+    if (!array) {
+        return array.error();
+    }
+    auto integers = midi.integers(**array);
+    if (!integers.has_value()) {
+        return content_error("QB array is not an integer array");
+    }
+    return *integers;
 }
 
-std::vector<std::uint32_t> fretbars_ms(const SightRead::Detail::QbMidi& midi,
-                                       std::uint32_t short_name_crc)
+// Reads an array of three integers, such as a time signature, returning a
+// diagnostic with error_message if it has another length.
+SightRead::ParseResult<std::array<std::uint32_t, 3>>
+integer_triple(const SightRead::Detail::QbMidi& midi,
+               const SightRead::Detail::QbArray* array,
+               const char* error_message)
 {
-    const auto fretbars_item
-        = find_item_by_id(midi.items, "_fretbars", short_name_crc);
-    const auto raw_fretbars
-        = std::any_cast<std::vector<std::any>>(fretbars_item.data);
+    if (array == nullptr) {
+        return content_error("QB array has no such array element");
+    }
+    const auto integers = midi.integers(*array);
+    if (!integers.has_value()) {
+        return content_error("QB array is not an integer array");
+    }
+    return std::visit(
+        [&](const auto& view)
+            -> SightRead::ParseResult<std::array<std::uint32_t, 3>> {
+            if (view.size() != 3) {
+                return content_error(error_message);
+            }
+            return std::array<std::uint32_t, 3> {view[0], view[1], view[2]};
+        },
+        *integers);
+}
 
-    std::vector<std::uint32_t> values;
-    values.reserve(raw_fretbars.size());
-    for (const auto& value : raw_fretbars) {
-        values.push_back(std::any_cast<std::uint32_t>(value));
+SightRead::ParseResult<std::vector<std::uint32_t>>
+fretbars_ms(const SightRead::Detail::QbMidi& midi,
+            std::uint32_t short_name_crc)
+{
+    const auto raw_fretbars
+        = find_integers_by_id(midi, "_fretbars", short_name_crc);
+    if (!raw_fretbars) {
+        return raw_fretbars.error();
     }
+    std::vector<std::uint32_t> values;
+    std::visit(
+        [&](const auto& view) {
+            values.reserve(view.size());
+            for (auto fretbar : view) {
+                values.push_back(fretbar);
+            }
+        },
+        *raw_fretbars);
 
     return values;
 }
@@ -3028,9 +3085,9 @@ struct QbNoteEvent {
     std::uint32_t flags;
 };
 
-std::vector<QbNoteEvent> note_events(const SightRead::Detail::QbMidi& midi,
-                                     std::uint32_t short_name_crc,
-                                     SightRead::Difficulty difficulty)
+SightRead::ParseResult<std::vector<QbNoteEvent>>
+note_events(const SightRead::Detail::QbMidi& midi, std::uint32_t short_name_crc,
+            SightRead::Difficulty difficulty)
 {
     const std::unordered_map<SightRead::Difficulty, std::string> diff_names {
         {SightRead::Difficulty::Easy, "easy"},
@@ -3039,19 +3096,23 @@ std::vector<QbNoteEvent> note_events(const SightRead::Detail::QbMidi& midi,
         {SightRead::Difficulty::Expert, "expert"}};
 
     const auto suffix = std::string("_song_") + diff_names.at(difficulty);
-    const auto notes_item = find_item_by_id(midi.items, suffix, short_name_crc);
-    const auto raw_notes
-        = std::any_cast<std::vector<std::any>>(notes_item.data);
-    assert((raw_notes.size() % 3) == 0);
-
-    std::vector<QbNoteEvent> values;
-    values.reserve(raw_notes.size() / 3);
-    for (auto i = 0U; i < raw_notes.size(); i += 3U) {
-        values.push_back(
-            {.position = std::any_cast<std::uint32_t>(raw_notes.at(i)),
-             .length = std::any_cast<std::uint32_t>(raw_notes.at(i + 1)),
-             .flags = std::any_cast<std::uint32_t>(raw_notes.at(i + 2))});
+    const auto raw_notes_result
+        = find_integers_by_id(midi, suffix, short_name_crc);
+    if (!raw_notes_result) {
+        return raw_notes_result.error();
     }
+    std::vector<QbNoteEvent> values;
+    std::visit(
+        [&](const auto& raw_notes) {
+            assert((raw_notes.size() % 3) == 0);
+            values.reserve(raw_notes.size() / 3);
+            for (auto i = 0U; i + 2 < raw_notes.size(); i += 3U) {
+                values.push_back({.position = raw_notes[i],
+                                  .length = raw_notes[i + 1],
+                                  .flags = raw_notes[i + 2]});
+            }
+        },
+        *raw_notes_result);
 
     return values;
 }
@@ -3062,23 +3123,27 @@ struct QbTimeSignature {
     std::uint32_t denominator;
 };
 
-std::vector<QbTimeSignature> qb_timesigs(const SightRead::Detail::QbMidi& midi,
-                                         std::uint32_t short_name_crc)
+SightRead::ParseResult<std::vector<QbTimeSignature>>
+qb_timesigs(const SightRead::Detail::QbMidi& midi, std::uint32_t short_name_crc)
 {
-    const auto timesigs_item
-        = find_item_by_id(midi.items, "_timesig", short_name_crc);
     const auto raw_timesigs
-        = std::any_cast<std::vector<std::any>>(timesigs_item.data);
+        = find_array_by_id(midi, "_timesig", short_name_crc);
+    if (!raw_timesigs) {
+        return raw_timesigs.error();
+    }
 
     std::vector<QbTimeSignature> values;
-    values.reserve(raw_timesigs.size());
-    for (const auto& value : raw_timesigs) {
-        const auto array = std::any_cast<std::vector<std::any>>(value);
-        assert(array.size() == 3);
-        values.push_back(
-            {.time_ms = std::any_cast<std::uint32_t>(array.at(0)),
-             .numerator = std::any_cast<std::uint32_t>(array.at(1)),
-             .denominator = std::any_cast<std::uint32_t>(array.at(2))});
+    values.reserve((*raw_timesigs)->size);
+    for (auto i = 0U; i < (*raw_timesigs)->size; ++i) {
+        const auto array
+            = integer_triple(midi, midi.array_element(**raw_timesigs, i),
+                             "Invalid time signature");
+        if (!array) {
+            return array.error();
+        }
+        values.push_back({.time_ms = (*array)[0],
+                          .numerator = (*array)[1],
+                          .denominator = (*array)[2]});
     }
 
     return values;
@@ -3090,9 +3155,9 @@ struct QbSpEvent {
     std::uint32_t note_count;
 };
 
-std::vector<QbSpEvent> sp_events(const SightRead::Detail::QbMidi& midi,
-                                 std::uint32_t short_name_crc,
-                                 SightRead::Difficulty difficulty)
+SightRead::ParseResult<std::vector<QbSpEvent>>
+sp_events(const SightRead::Detail::QbMidi& midi, std::uint32_t short_name_crc,
+          SightRead::Difficulty difficulty)
 {
     const std::unordered_map<SightRead::Difficulty, std::string> diff_names {
         {SightRead::Difficulty::Easy, "easy"},
@@ -3101,19 +3166,23 @@ std::vector<QbSpEvent> sp_events(const SightRead::Detail::QbMidi& midi,
         {SightRead::Difficulty::Expert, "expert"}};
 
     const auto suffix = std::string("_") + diff_names.at(difficulty) + "_star";
-    const auto sps_item = find_item_by_id(midi.items, suffix, short_name_crc);
-    const auto raw_phrases
-        = std::any_cast<std::vector<std::any>>(sps_item.data);
+    const auto raw_phrases = find_array_by_id(midi, suffix, short_name_crc);
+    if (!raw_phrases) {
+        return raw_phrases.error();
+    }
 
     std::vector<QbSpEvent> values;
-    values.reserve(raw_phrases.size());
-    for (const auto& value : raw_phrases) {
-        const auto array = std::any_cast<std::vector<std::any>>(value);
-        assert(array.size() == 3);
-        values.push_back(
-            {.position = std::any_cast<std::uint32_t>(array.at(0)),
-             .length = std::any_cast<std::uint32_t>(array.at(1)),
-             .note_count = std::any_cast<std::uint32_t>(array.at(2))});
+    values.reserve((*raw_phrases)->size);
+    for (auto i = 0U; i < (*raw_phrases)->size; ++i) {
+        const auto array
+            = integer_triple(midi, midi.array_element(**raw_phrases, i),
+                             "Invalid star power phrase");
+        if (!array) {
+            return array.error();
+        }
+        values.push_back({.position = (*array)[0],
+                          .length = (*array)[1],
+                          .note_count = (*array)[2]});
     }
 
     return values;
@@ -3125,24 +3194,69 @@ private:
     std::vector<std::uint32_t> m_fretbars_ms;
     std::vector<QbTimeSignature> m_timesigs;
 
-    [[nodiscard]] double ms_to_beats(std::uint32_t ms) const
+    // Returns the index of the first fretbar after ms. The search gallops out
+    // from hint, the index found for a nearby time, in steps that double until
+    // they pass ms, then binary searches the last step. This takes time
+    // logarithmic in the distance from hint, so converting ascending times
+    // costs O(n + m) in all, and times out of order cost no more than a binary
+    // search.
+    [[nodiscard]] std::size_t fretbar_after(std::uint32_t ms,
+                                            std::size_t hint) const
+    {
+        const auto size = m_fretbars_ms.size();
+        hint = std::min(hint, size);
+        std::size_t low = 0;
+        std::size_t high = size;
+        std::size_t step = 1;
+        if (hint < size && m_fretbars_ms[hint] <= ms) {
+            low = hint + 1;
+            while (hint + step < size && m_fretbars_ms[hint + step] <= ms) {
+                low = hint + step + 1;
+                step *= 2;
+            }
+            high = std::min(hint + step, size);
+        } else {
+            high = hint;
+            while (step <= hint && m_fretbars_ms[hint - step] > ms) {
+                high = hint - step;
+                step *= 2;
+            }
+            low = step <= hint ? hint - step + 1 : 0;
+        }
+        const auto first = std::next(m_fretbars_ms.cbegin(),
+                                     static_cast<std::ptrdiff_t>(low));
+        const auto last = std::next(m_fretbars_ms.cbegin(),
+                                    static_cast<std::ptrdiff_t>(high));
+        return static_cast<std::size_t>(std::distance(
+            m_fretbars_ms.cbegin(), std::upper_bound(first, last, ms)));
+    }
+
+    // after_index must be the index of a fretbar after ms other than the
+    // first.
+    [[nodiscard]] double ms_to_beats(std::uint32_t ms,
+                                     std::size_t after_index) const
     {
-        const auto it = std::ranges::upper_bound(m_fretbars_ms, ms);
-        assert(it != m_fretbars_ms.cbegin());
-        assert(it != m_fretbars_ms.cend());
-        const auto beat_after = *it;
-        const auto beat_before = *std::prev(it);
-        const auto after_index = std::distance(m_fretbars_ms.cbegin(), it);
-        const auto after_beat
-            = m_fretbars_beats.at(static_cast<std::size_t>(after_index));
+        const auto beat_after = m_fretbars_ms.at(after_index);
+        const auto beat_before = m_fretbars_ms.at(after_index - 1);
+        const auto after_beat = m_fretbars_beats.at(after_index);
         return after_beat
             - static_cast<double>(beat_after - ms)
-            * (after_beat
-               - m_fretbars_beats.at(static_cast<std::size_t>(after_index - 1)))
+            * (after_beat - m_fretbars_beats.at(after_index - 1))
             / static_cast<double>(beat_after - beat_before);
     }
 
+    [[nodiscard]] static SightRead::Tick beats_to_ticks(double beats)
+    {
+        return SightRead::Tick {static_cast<int>(RESOLUTION * beats)};
+    }
+
+    [[nodiscard]] static SightRead::ParseDiagnostic outside_fretbars()
+    {
+        return content_error("Time is outside of the fretbars");
+    }
+
 public:
+    // There must be at least two fretbars.
     QbTimeData(std::vector<std::uint32_t> fretbars,
                std::vector<QbTimeSignature> timesigs)
         : m_fretbars_ms {std::move(fretbars)}
@@ -3150,7 +3264,6 @@ public:
     {
         constexpr auto DEFAULT_TIME_SIG_DENOMINATOR = 4.0;
 
-        assert(!m_fretbars_ms.empty());
         m_fretbars_beats.reserve(m_fretbars_ms.size());
         m_fretbars_beats.emplace_back(0.0);
 
@@ -3194,9 +3307,33 @@ public:
         return bpms;
     }
 
-    [[nodiscard]] SightRead::Tick ms_to_ticks(std::uint32_t ms) const
+    [[nodiscard]] SightRead::ParseResult<SightRead::Tick>
+    ms_to_ticks(std::uint32_t ms) const
+    {
+        const auto after_index = fretbar_after(ms, 0);
+        if (after_index == 0 || after_index == m_fretbars_ms.size()) {
+            return outside_fretbars();
+        }
+        return beats_to_ticks(ms_to_beats(ms, after_index));
+    }
+
+    // Converts each time as the single time overload would. Each search starts
+    // from the fretbar found for the time before, so this takes time linear in
+    // the number of times and fretbars if the times are ascending.
+    [[nodiscard]] SightRead::ParseResult<std::vector<SightRead::Tick>>
+    ms_to_ticks(std::span<const std::uint32_t> times) const
     {
-        return SightRead::Tick {static_cast<int>(RESOLUTION * ms_to_beats(ms))};
+        std::vector<SightRead::Tick> ticks;
+        ticks.reserve(times.size());
+        std::size_t cursor = 0;
+        for (auto ms : times) {
+            cursor = fretbar_after(ms, cursor);
+            if (cursor == 0 || cursor == m_fretbars_ms.size()) {
+                return outside_fretbars();
+            }
+            ticks.push_back(beats_to_ticks(ms_to_beats(ms, cursor)));
+        }
+        return ticks;
     }
 
     [[nodiscard]] std::uint32_t sustain_threshold() const
@@ -3204,14 +3341,25 @@ public:
         return m_fretbars_ms.at(1) / 2;
     }
 
-    [[nodiscard]] std::vector<SightRead::TimeSignature> time_sigs() const
+    [[nodiscard]] SightRead::ParseResult<std::vector<SightRead::TimeSignature>>
+    time_sigs() const
     {
+        std::vector<std::uint32_t> times;
+        times.reserve(m_timesigs.size());
+        for (const auto& time_sig : m_timesigs) {
+            times.push_back(time_sig.time_ms);
+        }
+        const auto positions = ms_to_ticks(times);
+        if (!positions) {
+            return positions.error();
+        }
+
         std::vector<SightRead::TimeSignature> time_sigs;
         time_sigs.reserve(m_timesigs.size());
-        for (const auto& time_sig : m_timesigs) {
-            const auto position = ms_to_ticks(time_sig.time_ms);
+        for (auto i = 0U; i < m_timesigs.size(); ++i) {
+            const auto& time_sig = m_timesigs[i];
             time_sigs.push_back(
-                {.position = position,
+                {.position = (*positions)[i],
                  .numerator = static_cast<int>(time_sig.numerator),
                  .denominator = static_cast<int>(time_sig.denominator)});
         }
@@ -3225,19 +3373,35 @@ public:
     }
 };
 
-QbTimeData time_data(const SightRead::Detail::QbMidi& midi,
-                     std::uint32_t short_name_crc)
+SightRead::ParseResult<QbTimeData>
+time_data(const SightRead::Detail::QbMidi& midi, std::uint32_t short_name_crc)
 {
-    return {fretbars_ms(midi, short_name_crc),
-            qb_timesigs(midi, short_name_crc)};
+    auto fretbars = fretbars_ms(midi, short_name_crc);
+    if (!fretbars) {
+        return std::move(fretbars.error());
+    }
+    auto timesigs = qb_timesigs(midi, short_name_crc);
+    if (!timesigs) {
+        return std::move(timesigs.error());
+    }
+    if (fretbars->size() < 2) {
+        return content_error("QB file has too few fretbars");
+    }
+    return QbTimeData {std::move(*fretbars), std::move(*timesigs)};
 }
 
-SightRead::TempoMap tempo_map(const QbTimeData& time_data)
+SightRead::ParseResult<SightRead::TempoMap>
+tempo_map(const QbTimeData& time_data)
 {
-    return {time_data.time_sigs(), time_data.bpms(), {}, RESOLUTION};
+    auto time_sigs = time_data.time_sigs();
+    if (!time_sigs) {
+        return std::move(time_sigs.error());
+    }
+    return SightRead::Detail::try_tempo_map(std::move(*time_sigs),
+                                            time_data.bpms(), {}, RESOLUTION);
 }
 
-std::optional<SightRead::NoteTrack>
+SightRead::ParseResult<std::optional<SightRead::NoteTrack>>
 note_track(const SightRead::Detail::QbMidi& midi, std::uint32_t short_name_crc,
            SightRead::Difficulty difficulty,
            std::shared_ptr<SightRead::SongGlobalData> global_data,
@@ -3246,31 +3410,61 @@ note_track(const SightRead::Detail::QbMidi& midi, std::uint32_t short_name_crc,
     constexpr auto NUMBER_OF_FRETS = 5U;
     constexpr auto FRET_MASK = (1 << NUMBER_OF_FRETS) - 1;
 
-    const auto events = note_events(midi, short_name_crc, difficulty);
+    const auto events_result = note_events(midi, short_name_crc, difficulty);
+    if (!events_result) {
+        return events_result.error();
+    }
+    const auto& events = *events_result;
     if (events.empty()) {
-        return {};
+        return std::optional<SightRead::NoteTrack> {};
     }
 
-    const auto phrase_events = sp_events(midi, short_name_crc, difficulty);
+    const auto phrase_result = sp_events(midi, short_name_crc, difficulty);
+    if (!phrase_result) {
+        return phrase_result.error();
+    }
+    const auto& phrase_events = *phrase_result;
 
+    // Notes are in ascending order, and so are their ends unless sustains
+    // overlap, so starts and ends are each converted in one pass over the
+    // fretbars.
     const auto sustain_threshold = timedata.sustain_threshold();
-    std::vector<SightRead::Note> notes;
-    notes.reserve(events.size());
+    std::vector<std::uint32_t> note_starts;
+    std::vector<std::uint32_t> note_ends;
+    note_starts.reserve(events.size());
+    note_ends.reserve(events.size());
     for (const auto& event : events) {
         if ((event.flags & FRET_MASK) == 0) {
             continue;
         }
 
-        SightRead::Note note;
-        note.flags = SightRead::FLAGS_FIVE_FRET_GUITAR;
         auto ms_length = event.length;
         if (ms_length <= sustain_threshold) {
             ms_length = 0;
         }
-        note.position = timedata.ms_to_ticks(event.position);
-        const auto end_position
-            = timedata.ms_to_ticks(event.position + ms_length);
-        const auto length = end_position - note.position;
+        note_starts.push_back(event.position);
+        note_ends.push_back(event.position + ms_length);
+    }
+    const auto start_ticks = timedata.ms_to_ticks(note_starts);
+    if (!start_ticks) {
+        return start_ticks.error();
+    }
+    const auto end_ticks = timedata.ms_to_ticks(note_ends);
+    if (!end_ticks) {
+        return end_ticks.error();
+    }
+
+    std::vector<SightRead::Note> notes;
+    notes.reserve(start_ticks->size());
+    for (const auto& event : events) {
+        if ((event.flags & FRET_MASK) == 0) {
+            continue;
+        }
+
+        SightRead::Note note;
+        note.flags = SightRead::FLAGS_FIVE_FRET_GUITAR;
+        note.position = (*start_ticks)[notes.size()];
+        const auto length = (*end_ticks)[notes.size()] - note.position;
 
         for (auto i = 0U; i < NUMBER_OF_FRETS; ++i) {
             if ((event.flags & (1 << i)) != 0) {
@@ -3285,12 +3479,28 @@ note_track(const SightRead::Detail::QbMidi& midi, std::uint32_t short_name_crc,
         notes.push_back(note);
     }
 
+    std::vector<std::uint32_t> phrase_starts;
+    std::vector<std::uint32_t> phrase_ends;
+    phrase_starts.reserve(phrase_events.size());
+    phrase_ends.reserve(phrase_events.size());
+    for (const auto& event : phrase_events) {
+        phrase_starts.push_back(event.position);
+        phrase_ends.push_back(event.position + event.length);
+    }
+    const auto phrase_start_ticks = timedata.ms_to_ticks(phrase_starts);
+    if (!phrase_start_ticks) {
+        return phrase_start_ticks.error();
+    }
+    const auto phrase_end_ticks = timedata.ms_to_ticks(phrase_ends);
+    if (!phrase_end_ticks) {
+        return phrase_end_ticks.error();
+    }
+
     std::vector<SightRead::StarPower> sp_phrases;
     sp_phrases.reserve(phrase_events.size());
-    for (const auto& event : phrase_events) {
-        const auto position = timedata.ms_to_ticks(event.position);
-        const auto end_position
-            = timedata.ms_to_ticks(event.position + event.length);
+    for (auto i = 0U; i < phrase_events.size(); ++i) {
+        const auto position = (*phrase_start_ticks)[i];
+        const auto end_position = (*phrase_end_ticks)[i];
         sp_phrases.push_back(
             {.position = position, .length = end_position - position});
     }
@@ -3299,11 +3509,12 @@ note_track(const SightRead::Detail::QbMidi& midi, std::uint32_t short_name_crc,
                                 SightRead::TrackType::FiveFret,
                                 std::move(global_data)};
     track.sp_phrases(std::move(sp_phrases));
-    return track;
+    return std::optional<SightRead::NoteTrack> {std::move(track)};
 }
 
-std::optional<SightRead::PracticeSection>
-section_from_struct(const SightRead::Detail::QbStructData& section_struct,
+SightRead::ParseResult<std::optional<SightRead::PracticeSection>>
+section_from_struct(const SightRead::Detail::QbMidi& midi,
+                    const SightRead::Detail::QbStructData& section_struct,
                     const QbTimeData& timedata)
 {
     constexpr auto MARKER_CRC = crc32("marker");
@@ -3312,18 +3523,26 @@ section_from_struct(const SightRead::Detail::QbStructData& section_struct,
     std::string name;
     SightRead::Tick time {0};
 
-    for (const auto& item : section_struct.items) {
+    for (const auto& item : midi.items_of(section_struct)) {
         if (item.props.id == MARKER_CRC) {
             switch (item.info.type) {
             case SightRead::Detail::QbItemType::Pointer: {
-                const auto pointer = std::any_cast<std::uint32_t>(item.data);
-                name = section_name_from_pointer(pointer);
+                const auto pointer
+                    = SightRead::Detail::qb_value_as<std::uint32_t>(item.data);
+                if (!pointer.has_value()) {
+                    return content_error("Unexpected QB value type");
+                }
+                name = section_name_from_pointer(*pointer);
                 break;
             }
-            case SightRead::Detail::QbItemType::WideString:
-                name = boost::locale::conv::from_utf(
-                    std::any_cast<std::wstring>(item.data), "Latin1");
+            case SightRead::Detail::QbItemType::WideString: {
+                const auto* wide_name = midi.wide_string(item.data);
+                if (wide_name == nullptr) {
+                    return content_error("Unexpected QB value type");
+                }
+                name = SightRead::Detail::utf16_to_utf8(*wide_name);
                 break;
+            }
             case SightRead::Detail::QbItemType::Array:
             case SightRead::Detail::QbItemType::Float:
             case SightRead::Detail::QbItemType::Integer:
@@ -3332,41 +3551,55 @@ section_from_struct(const SightRead::Detail::QbStructData& section_struct,
             case SightRead::Detail::QbItemType::Struct:
             case SightRead::Detail::QbItemType::StructFlag:
             default:
-                throw SightRead::ParseError("Unexpected section name type");
+                return content_error("Unexpected section name type");
             }
         } else if (item.props.id == TIME_CRC) {
-            const auto time_ms = std::any_cast<std::int32_t>(item.props.value);
-            const auto unsigned_time_ms = static_cast<std::uint32_t>(time_ms);
+            const auto time_ms = SightRead::Detail::qb_value_as<std::int32_t>(
+                item.props.value);
+            if (!time_ms.has_value()) {
+                return content_error("Unexpected QB value type");
+            }
+            const auto unsigned_time_ms = static_cast<std::uint32_t>(*time_ms);
             if (unsigned_time_ms > timedata.last_fretbar()) {
-                return {};
+                return std::optional<SightRead::PracticeSection> {};
+            }
+            const auto ticks = timedata.ms_to_ticks(unsigned_time_ms);
+            if (!ticks) {
+                return ticks.error();
             }
-            time = timedata.ms_to_ticks(
-                static_cast<std::uint32_t>(unsigned_time_ms));
+            time = *ticks;
         } else {
-            throw SightRead::ParseError("Unexpected marker struct item");
+            return content_error("Unexpected marker struct item");
         }
     }
 
-    return SightRead::PracticeSection {.name = std::move(name), .start = time};
+    return std::optional<SightRead::PracticeSection> {
+        {.name = std::move(name), .start = time}};
 }
 
-std::vector<SightRead::PracticeSection>
+SightRead::ParseResult<std::vector<SightRead::PracticeSection>>
 practice_sections(const SightRead::Detail::QbMidi& midi,
                   std::uint32_t short_name_crc, const QbTimeData& timedata)
 {
-    const auto markers_item
-        = find_item_by_id(midi.items, "_markers", short_name_crc);
     const auto raw_markers
-        = std::any_cast<std::vector<std::any>>(markers_item.data);
+        = find_array_by_id(midi, "_markers", short_name_crc);
+    if (!raw_markers) {
+        return raw_markers.error();
+    }
 
     std::vector<SightRead::PracticeSection> sections;
-    sections.reserve(raw_markers.size());
-    for (const auto& value : raw_markers) {
-        const auto section_struct
-            = std::any_cast<SightRead::Detail::QbStructData>(value);
-        const auto section = section_from_struct(section_struct, timedata);
-        if (section.has_value()) {
-            sections.push_back(*section);
+    sections.reserve((*raw_markers)->size);
+    for (auto i = 0U; i < (*raw_markers)->size; ++i) {
+        const auto* section_struct = midi.struct_element(**raw_markers, i);
+        if (section_struct == nullptr) {
+            return content_error("QB array has no such struct element");
+        }
+        auto section = section_from_struct(midi, *section_struct, timedata);
+        if (!section) {
+            return std::move(section.error());
+        }
+        if (section->has_value()) {
+            sections.push_back(std::move(**section));
         }
     }
 
@@ -3380,33 +3613,65 @@ SightRead::Detail::QbMidiConverter::QbMidiConverter(
     , m_artist {std::move(metadata.artist)}
     , m_charter {std::move(metadata.charter)}
     , m_short_name_crc {crc32(short_name)}
+    , m_limit_checker {SightRead::ParseLimits {}}
 {
 }
 
+SightRead::Detail::QbMidiConverter&
+SightRead::Detail::QbMidiConverter::limit_checker(
+    const SightRead::Detail::LimitChecker& limit_checker)
+{
+    m_limit_checker = limit_checker;
+    return *this;
+}
+
 SightRead::Song SightRead::Detail::QbMidiConverter::convert(
     const SightRead::Detail::QbMidi& midi) const
+{
+    return try_convert(midi).value();
+}
+
+SightRead::ParseResult<SightRead::Song>
+SightRead::Detail::QbMidiConverter::try_convert(
+    const SightRead::Detail::QbMidi& midi) const
 {
     constexpr std::array<SightRead::Difficulty, 4> DIFFICULTIES {
         SightRead::Difficulty::Easy, SightRead::Difficulty::Medium,
         SightRead::Difficulty::Hard, SightRead::Difficulty::Expert};
 
     const auto timedata = time_data(midi, m_short_name_crc);
+    if (!timedata) {
+        return timedata.error();
+    }
+    auto tempos = tempo_map(*timedata);
+    if (!tempos) {
+        return std::move(tempos.error());
+    }
+    auto sections = practice_sections(midi, m_short_name_crc, *timedata);
+    if (!sections) {
+        return std::move(sections.error());
+    }
 
     SightRead::Song song;
     song.global_data().resolution(RESOLUTION);
     song.global_data().name(m_song_name);
     song.global_data().artist(m_artist);
     song.global_data().charter(m_charter);
-    song.global_data().tempo_map(tempo_map(timedata));
-    song.global_data().practice_sections(
-        practice_sections(midi, m_short_name_crc, timedata));
+    song.global_data().tempo_map(std::move(*tempos));
+    song.global_data().practice_sections(std::move(*sections));
 
     for (const auto diff : DIFFICULTIES) {
+        if (auto exceeded = m_limit_checker.check_time()) {
+            return std::move(*exceeded);
+        }
         auto track = note_track(midi, m_short_name_crc, diff,
-                                song.global_data_ptr(), timedata);
-        if (track.has_value()) {
+                                song.global_data_ptr(), *timedata);
+        if (!track) {
+            return std::move(track.error());
+        }
+        if (track->has_value()) {
             song.add_note_track(SightRead::Instrument::Guitar, diff,
-                                std::move(*track));
+                                std::move(**track));
         }
     }
 
@@ -4,6 +4,7 @@
 #include <string>
 #include <string_view>
 
+#include "sightread/detail/limitchecker.hpp"
 #include "sightread/detail/qbmidi.hpp"
 #include "sightread/metadata.hpp"
 #include "sightread/song.hpp"
@@ -15,10 +16,21 @@ private:
     std::string m_artist;
     std::string m_charter;
     std::uint32_t m_short_name_crc;
+    SightRead::Detail::LimitChecker m_limit_checker;
 
 public:
     QbMidiConverter(SightRead::Metadata metadata, std::string_view short_name);
+    // Sets the checker whose time budget conversion is held to. convert throws
+    // SightRead::ParseLimitError if the budget runs out before a track is
+    // converted, and try_convert returns a diagnostic. By default there is no
+    // budget.
+    QbMidiConverter&
+    limit_checker(const SightRead::Detail::LimitChecker& limit_checker);
     SightRead::Song convert(const SightRead::Detail::QbMidi& midi) const;
+    // Like convert, but returns a diagnostic instead of throwing if the QB
+    // file does not describe a usable song.
+    [[nodiscard]] SightRead::ParseResult<SightRead::Song>
+    try_convert(const SightRead::Detail::QbMidi& midi) const;
 };
 }
 
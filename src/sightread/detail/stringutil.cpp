@@ -1,33 +1,148 @@
+#include <array>
+#include <bit>
 #include <charconv>
+#include <cstring>
 
-#include <boost/locale.hpp>
+#if defined(__SSE2__) || defined(_M_X64)                                      \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIGHTREAD_USE_SSE2
+#include <emmintrin.h>
+#endif
 
 #include "sightread/detail/stringutil.hpp"
 #include "sightread/tempomap.hpp"
 
 namespace {
-std::string utf16_to_utf8_string(std::string_view input)
+// Returns the position of the first byte at or after position that is not
+// ASCII, or input.size() if there is none.
+std::size_t skip_ascii(std::string_view input, std::size_t position)
+{
+#ifdef SIGHTREAD_USE_SSE2
+    constexpr std::size_t BLOCK_SIZE = 16;
+
+    for (; position + BLOCK_SIZE <= input.size(); position += BLOCK_SIZE) {
+        const auto block = _mm_loadu_si128(
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            reinterpret_cast<const __m128i*>(input.data() + position));
+        const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(block));
+        if (mask != 0) {
+            return position + static_cast<std::size_t>(std::countr_zero(mask));
+        }
+    }
+#endif
+
+    while (position < input.size()
+           && static_cast<unsigned char>(input[position]) < 0x80) {
+        ++position;
+    }
+    return position;
+}
+
+void append_utf8(std::string& output, char32_t code_point)
 {
-    if (input.size() % 2 != 0) {
-        throw SightRead::ParseError("UTF-16 strings must have even length");
+    constexpr char32_t ONE_BYTE_LIMIT = 0x80;
+    constexpr char32_t TWO_BYTE_LIMIT = 0x800;
+    constexpr char32_t THREE_BYTE_LIMIT = 0x10000;
+    constexpr char32_t CONTINUATION_MASK = 0x3F;
+    constexpr char32_t CONTINUATION_BITS = 0x80;
+
+    const auto continuation = [&](int shift) {
+        return static_cast<char>(((code_point >> shift) & CONTINUATION_MASK)
+                                 | CONTINUATION_BITS);
+    };
+
+    if (code_point < ONE_BYTE_LIMIT) {
+        output.push_back(static_cast<char>(code_point));
+    } else if (code_point < TWO_BYTE_LIMIT) {
+        output.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        output.push_back(continuation(0));
+    } else if (code_point < THREE_BYTE_LIMIT) {
+        output.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        output.push_back(continuation(6));
+        output.push_back(continuation(0));
+    } else {
+        output.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        output.push_back(continuation(12));
+        output.push_back(continuation(6));
+        output.push_back(continuation(0));
     }
+}
+
+// Appends the leading run of ASCII code units of input to output, 8 at a time
+// where SSE2 is available, and returns how many were appended.
+std::size_t append_utf16_ascii_run(std::string& output,
+                                   std::u16string_view input)
+{
+    std::size_t position = 0;
+
+#ifdef SIGHTREAD_USE_SSE2
+    constexpr std::size_t BLOCK_SIZE = 8;
+
+    const auto non_ascii_bits = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const auto zero = _mm_setzero_si128();
+    for (; position + BLOCK_SIZE <= input.size(); position += BLOCK_SIZE) {
+        const auto block = _mm_loadu_si128(
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            reinterpret_cast<const __m128i*>(input.data() + position));
+        const auto non_ascii = _mm_cmpeq_epi16(
+            _mm_and_si128(block, non_ascii_bits), zero);
+        if (_mm_movemask_epi8(non_ascii) != 0xFFFF) {
+            break;
+        }
+        std::array<char, 2 * BLOCK_SIZE> bytes {};
+        _mm_storeu_si128(
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            reinterpret_cast<__m128i*>(bytes.data()),
+            _mm_packus_epi16(block, block));
+        output.append(bytes.data(), BLOCK_SIZE);
+    }
+#endif
+
+    while (position < input.size() && input[position] < 0x80) {
+        output.push_back(static_cast<char>(input[position]));
+        ++position;
+    }
+    return position;
+}
 
+// Returns the position of the first character at or after position that is
+// not whitespace, or input.size() if there is none. Lines start after one of
+// these runs, so this is a plain loop rather than find_first_not_of, which
+// searches its set for every character.
+std::size_t skip_whitespace_from(std::string_view input, std::size_t position)
+{
+    while (position < input.size()) {
+        switch (input[position]) {
+        case ' ':
+        case '\f':
+        case '\n':
+        case '\r':
+        case '\t':
+        case '\v':
+            ++position;
+            break;
+        default:
+            return position;
+        }
+    }
+    return position;
+}
+
+std::string utf16_to_utf8_string(std::string_view input)
+{
     // I'm pretty sure I really do need the reinterpret_cast here.
     std::u16string_view utf16_string_view {
         reinterpret_cast<const char16_t*>(input.data()), // NOLINT
         input.size() / 2};
 
-    return boost::locale::conv::utf_to_utf<char>(
-        utf16_string_view.data(),
-        utf16_string_view.data() + utf16_string_view.size());
+    return SightRead::Detail::utf16_to_utf8(utf16_string_view);
 }
 }
 
 namespace SightRead::Detail {
 std::string_view skip_whitespace(std::string_view input)
 {
-    const auto first_non_ws_location = input.find_first_not_of(" \f\n\r\t\v");
-    input.remove_prefix(std::min(first_non_ws_location, input.size()));
+    input.remove_prefix(skip_whitespace_from(input, 0));
     return input;
 }
 
@@ -53,27 +168,210 @@ std::string_view break_off_newline(std::string_view& input)
     return line;
 }
 
+std::size_t find_newline(std::string_view input, std::size_t position)
+{
+    if (position >= input.size()) {
+        return std::string_view::npos;
+    }
+    const auto* newline = static_cast<const char*>(std::memchr(
+        input.data() + position, '\n', input.size() - position));
+    if (newline == nullptr) {
+        return std::string_view::npos;
+    }
+    return static_cast<std::size_t>(newline - input.data());
+}
+
+LineReader::LineReader(std::string_view input)
+    : m_input {input}
+{
+}
+
+std::string_view LineReader::next_line()
+{
+    if (empty()) {
+        throw SightRead::ParseError("No lines left");
+    }
+
+    const auto newline_location = find_newline(m_input, m_position);
+    if (newline_location == std::string_view::npos) {
+        const auto line = m_input.substr(m_position);
+        m_position = m_input.size();
+        return line;
+    }
+
+    auto line_end = newline_location;
+    if (line_end > m_position && m_input[line_end - 1] == '\r') {
+        --line_end;
+    }
+    const auto line = m_input.substr(m_position, line_end - m_position);
+    m_position = skip_whitespace_from(m_input, newline_location);
+    return line;
+}
+
 std::string to_utf8_string(std::string_view input)
+{
+    std::string buffer;
+    const auto utf8_string = to_utf8_view(input, buffer);
+    if (utf8_string.data() == buffer.data()) {
+        return buffer;
+    }
+    return std::string(utf8_string);
+}
+
+std::string utf16_to_utf8(std::u16string_view input)
+{
+    constexpr char32_t SURROGATE_MASK = 0xFC00;
+    constexpr char32_t HIGH_SURROGATE = 0xD800;
+    constexpr char32_t LOW_SURROGATE = 0xDC00;
+    constexpr char32_t SUPPLEMENTARY_PLANE_START = 0x10000;
+
+    std::string output;
+    output.reserve(input.size());
+    while (!input.empty()) {
+        input.remove_prefix(append_utf16_ascii_run(output, input));
+        if (input.empty()) {
+            break;
+        }
+
+        const char32_t unit = input.front();
+        input.remove_prefix(1);
+        if ((unit & SURROGATE_MASK) == LOW_SURROGATE) {
+            continue;
+        }
+        if ((unit & SURROGATE_MASK) != HIGH_SURROGATE) {
+            append_utf8(output, unit);
+            continue;
+        }
+        if (input.empty()) {
+            break;
+        }
+        // Like Boost.Locale, the unit after a high surrogate is consumed even
+        // if it does not complete the pair.
+        const char32_t low_unit = input.front();
+        input.remove_prefix(1);
+        if ((low_unit & SURROGATE_MASK) == LOW_SURROGATE) {
+            append_utf8(output,
+                        SUPPLEMENTARY_PLANE_START
+                            + ((unit - HIGH_SURROGATE) << 10)
+                            + (low_unit - LOW_SURROGATE));
+        }
+    }
+    return output;
+}
+
+std::string latin1_to_utf8(std::string_view input)
+{
+    std::string output;
+    output.reserve(input.size());
+    std::size_t position = 0;
+    while (position < input.size()) {
+        const auto ascii_end = skip_ascii(input, position);
+        output.append(input.substr(position, ascii_end - position));
+        position = ascii_end;
+        if (position < input.size()) {
+            append_utf8(output, static_cast<unsigned char>(input[position]));
+            ++position;
+        }
+    }
+    return output;
+}
+
+std::string_view to_utf8_view(std::string_view input, std::string& buffer)
+{
+    return try_to_utf8_view(input, buffer).value();
+}
+
+SightRead::ParseResult<std::string_view>
+try_to_utf8_view(std::string_view input, std::string& buffer)
 {
     if (input.starts_with("\xEF\xBB\xBF")) {
         // Trim off UTF-8 BOM.
         input.remove_prefix(3);
-        return std::string(input);
+        return input;
     }
 
     if (input.starts_with("\xFF\xFE")) {
+        if (input.size() % 2 != 0) {
+            return SightRead::ParseDiagnostic {
+                .category = SightRead::ParseErrorCategory::Encoding,
+                .byte_offset = input.size() - 1,
+                .message = "UTF-16 strings must have even length"};
+        }
         // Trim off UTF-16le BOM.
         input.remove_prefix(2);
-        return utf16_to_utf8_string(input);
+        buffer = utf16_to_utf8_string(input);
+        return std::string_view {buffer};
+    }
+
+    if (is_valid_utf8(input)) {
+        return input;
     }
+    buffer = latin1_to_utf8(input);
+    return std::string_view {buffer};
+}
+
+bool is_ascii(std::string_view input)
+{
+    return skip_ascii(input, 0) == input.size();
+}
+
+bool is_valid_utf8(std::string_view input)
+{
+    constexpr unsigned char CONTINUATION_MIN = 0x80;
+    constexpr unsigned char CONTINUATION_MAX = 0xBF;
+
+    const auto byte_at = [&](std::size_t position) {
+        return static_cast<unsigned char>(input[position]);
+    };
+
+    std::size_t position = 0;
+    while (true) {
+        position = skip_ascii(input, position);
+        if (position == input.size()) {
+            return true;
+        }
+
+        // The ranges for the second byte exclude overlong encodings,
+        // surrogates, and code points past U+10FFFF.
+        const auto lead = byte_at(position);
+        std::size_t continuation_count = 0;
+        auto second_min = CONTINUATION_MIN;
+        auto second_max = CONTINUATION_MAX;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            continuation_count = 1;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            continuation_count = 2;
+            if (lead == 0xE0) {
+                second_min = 0xA0;
+            } else if (lead == 0xED) {
+                second_max = 0x9F;
+            }
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            continuation_count = 3;
+            if (lead == 0xF0) {
+                second_min = 0x90;
+            } else if (lead == 0xF4) {
+                second_max = 0x8F;
+            }
+        } else {
+            return false;
+        }
 
-    auto utf8_copy = boost::locale::conv::utf_to_utf<char>(
-        input.data(), input.data() + input.size());
-    if (std::ranges::equal(utf8_copy, input)) {
-        return utf8_copy;
+        if (input.size() - position <= continuation_count) {
+            return false;
+        }
+        const auto second = byte_at(position + 1);
+        if (second < second_min || second > second_max) {
+            return false;
+        }
+        for (auto i = 2U; i <= continuation_count; ++i) {
+            const auto byte = byte_at(position + i);
+            if (byte < CONTINUATION_MIN || byte > CONTINUATION_MAX) {
+                return false;
+            }
+        }
+        position += continuation_count + 1;
     }
-    return boost::locale::conv::to_utf<char>(
-        input.data(), input.data() + input.size(), "Latin1");
 }
 
 // Convert a string_view to an int. If there are any problems with the input,
@@ -1,10 +1,13 @@
 #ifndef SIGHTREAD_DETAIL_STRINGUTIL_HPP
 #define SIGHTREAD_DETAIL_STRINGUTIL_HPP
 
+#include <cstddef>
 #include <optional>
 #include <string>
 #include <string_view>
 
+#include "sightread/parseresult.hpp"
+
 namespace SightRead::Detail {
 // This returns a string_view from the start of input until a carriage return
 // or newline. input is changed to point to the first character past the
@@ -13,9 +16,51 @@ std::string_view break_off_newline(std::string_view& input);
 
 std::string_view skip_whitespace(std::string_view input);
 
+// Returns the position of the first newline character in input at or after
+// position, or std::string_view::npos if there is none.
+std::size_t find_newline(std::string_view input, std::size_t position);
+
+// Splits input into lines exactly as repeated calls to break_off_newline
+// would, without copying input or allocating.
+class LineReader {
+private:
+    std::string_view m_input;
+    std::size_t m_position {0};
+
+public:
+    explicit LineReader(std::string_view input);
+    [[nodiscard]] bool empty() const { return m_position == m_input.size(); }
+    // The position in input of the start of the next line.
+    [[nodiscard]] std::size_t position() const { return m_position; }
+    std::string_view next_line();
+};
+
 // Convert a UTF-8 or UTF-16le string to a UTF-8 string.
 std::string to_utf8_string(std::string_view input);
 
+// Like to_utf8_string, but if input is already UTF-8 this returns a view of
+// input without its BOM rather than a copy. Otherwise the converted string is
+// stored in buffer and a view of buffer is returned.
+std::string_view to_utf8_view(std::string_view input, std::string& buffer);
+
+// Like to_utf8_view, but returns a diagnostic instead of throwing if input
+// cannot be decoded.
+SightRead::ParseResult<std::string_view>
+try_to_utf8_view(std::string_view input, std::string& buffer);
+
+// Convert UTF-16 code units to UTF-8. Unpaired surrogates are skipped.
+std::string utf16_to_utf8(std::u16string_view input);
+
+// Convert a Latin-1 string to UTF-8.
+std::string latin1_to_utf8(std::string_view input);
+
+// Returns whether every character of input is ASCII.
+bool is_ascii(std::string_view input);
+
+// Returns whether input is valid UTF-8. Runs of ASCII are checked 16 bytes at
+// a time where SSE2 is available.
+bool is_valid_utf8(std::string_view input);
+
 // Convert a string_view to an int. If there are any problems with the input,
 // this function returns std::nullopt.
 std::optional<int> string_view_to_int(std::string_view input);
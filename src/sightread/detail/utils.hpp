@@ -7,21 +7,25 @@
 #include <cstdint>
 #include <span>
 
-#include "sightread/tempomap.hpp"
+#include "sightread/parseresult.hpp"
 
-[[noreturn]] inline void throw_on_insufficient_bytes()
+// The diagnostic for data that ends partway through what is being read, where
+// byte_offset is the position of the read in the parsed data.
+inline SightRead::ParseDiagnostic insufficient_bytes(std::size_t byte_offset)
 {
-    throw SightRead::ParseError("insufficient bytes");
+    return {.category = SightRead::ParseErrorCategory::Syntax,
+            .byte_offset = byte_offset,
+            .message = "insufficient bytes"};
 }
 
+// The read_* functions and pop_front do not check their input; callers must
+// make sure there are enough bytes, so that running out can be reported with
+// the caller's position.
 template <typename T>
 T read_four_byte_be(std::span<const std::uint8_t> span, std::size_t offset)
 {
     static_assert(sizeof(T) == 4);
 
-    if (span.size() < offset + 4) {
-        throw_on_insufficient_bytes();
-    }
     const auto bytes = span[offset] << (3 * CHAR_BIT)
         | span[offset + 1] << (2 * CHAR_BIT) | span[offset + 2] << CHAR_BIT
         | span[offset + 3];
@@ -33,9 +37,6 @@ T read_four_byte_le(std::span<const std::uint8_t> span, std::size_t offset)
 {
     static_assert(sizeof(T) == 4);
 
-    if (span.size() < offset + 4) {
-        throw_on_insufficient_bytes();
-    }
     const auto bytes = span[offset] | span[offset + 1] << CHAR_BIT
         | span[offset + 2] << (2 * CHAR_BIT)
         | span[offset + 3] << (3 * CHAR_BIT);
@@ -47,9 +48,6 @@ T read_two_byte_be(std::span<const std::uint8_t> span, std::size_t offset)
 {
     static_assert(sizeof(T) == 2);
 
-    if (span.size() < offset + 2) {
-        throw_on_insufficient_bytes();
-    }
     const auto bytes = static_cast<std::int16_t>(span[offset] << CHAR_BIT
                                                  | span[offset + 1]);
     return std::bit_cast<T>(bytes);
@@ -60,9 +58,6 @@ T read_two_byte_le(std::span<const std::uint8_t> span, std::size_t offset)
 {
     static_assert(sizeof(T) == 2);
 
-    if (span.size() < offset + 2) {
-        throw_on_insufficient_bytes();
-    }
     const auto bytes = static_cast<std::int16_t>(
         span[offset] | span[offset + 1] << CHAR_BIT);
     return std::bit_cast<T>(bytes);
@@ -70,9 +65,6 @@ T read_two_byte_le(std::span<const std::uint8_t> span, std::size_t offset)
 
 inline std::uint8_t pop_front(std::span<const std::uint8_t>& data)
 {
-    if (data.empty()) {
-        throw_on_insufficient_bytes();
-    }
     const auto value = data.front();
     data = data.subspan(1);
     return value;
@@ -87,8 +87,8 @@ SightRead::Metadata parse_ini(std::string_view data)
         "artist",         "charter", "eighthnote_hopo",         "frets",
         "hopo_frequency", "name",    "sustain_cutoff_threshold"};
 
-    std::string u8_string = to_utf8_string(data);
-    data = u8_string;
+    std::string u8_buffer;
+    data = to_utf8_view(data, u8_buffer);
 
     SightRead::Metadata metadata;
     metadata.name = "Unknown Song";
@@ -1,14 +1,36 @@
+#include <cstddef>
+#include <optional>
+#include <string_view>
 #include <utility>
 
+#include "sightread/detail/limitchecker.hpp"
+#include "sightread/detail/mappedfile.hpp"
 #include "sightread/detail/midiconverter.hpp"
 #include "sightread/midiparser.hpp"
 
+namespace {
+std::optional<SightRead::ParseDiagnostic>
+check_decoded_midi(const SightRead::Detail::LimitChecker& limit_checker,
+                   const SightRead::Detail::Midi& midi)
+{
+    std::size_t event_count = 0;
+    for (const auto& track : midi.tracks) {
+        event_count += track.size();
+    }
+    if (auto exceeded = limit_checker.check_events(event_count)) {
+        return exceeded;
+    }
+    return limit_checker.check_time();
+}
+}
+
 SightRead::MidiParser::MidiParser(SightRead::Metadata metadata)
     : m_metadata {std::move(metadata)}
     , m_permitted_instruments {SightRead::all_instruments()}
     , m_permit_solos {true}
     , m_allow_open_chords {true}
     , m_use_sustain_cutoff_threshold {true}
+    , m_max_threads {1}
 {
 }
 
@@ -39,16 +61,69 @@ SightRead::MidiParser& SightRead::MidiParser::use_sustain_cutoff_threshold(
     return *this;
 }
 
+SightRead::MidiParser&
+SightRead::MidiParser::max_threads(unsigned int max_threads)
+{
+    m_max_threads = max_threads;
+    return *this;
+}
+
+SightRead::MidiParser&
+SightRead::MidiParser::limits(SightRead::ParseLimits limits)
+{
+    m_limits = std::move(limits);
+    return *this;
+}
+
 SightRead::Song
 SightRead::MidiParser::parse(std::span<const std::uint8_t> data) const
 {
-    const auto midi = SightRead::Detail::parse_midi(data);
+    return try_parse(data).value();
+}
 
+SightRead::ParseResult<SightRead::Song>
+SightRead::MidiParser::try_parse(std::span<const std::uint8_t> data) const
+{
+    const SightRead::Detail::LimitChecker limit_checker {m_limits};
+    if (auto exceeded = limit_checker.check_payload(data.size())) {
+        return std::move(*exceeded);
+    }
     const auto converter
         = SightRead::Detail::MidiConverter(m_metadata)
               .permit_instruments(m_permitted_instruments)
               .parse_solos(m_permit_solos)
               .allow_open_chords(m_allow_open_chords)
-              .use_sustain_cutoff_threshold(m_use_sustain_cutoff_threshold);
-    return converter.convert(midi);
+              .use_sustain_cutoff_threshold(m_use_sustain_cutoff_threshold)
+              .max_threads(m_max_threads)
+              .limit_checker(limit_checker);
+    const auto chunks = SightRead::Detail::find_midi_chunks(data);
+    if (!chunks) {
+        return chunks.error();
+    }
+    // Every track chunk is counted before any is decoded, so a file with too
+    // many tracks costs no more than the pass that finds them.
+    if (auto exceeded = limit_checker.check_tracks(chunks->tracks.size())) {
+        return std::move(*exceeded);
+    }
+    // Tracks the converter would discard are skipped without being decoded.
+    const auto midi = SightRead::Detail::decode_midi_chunks(
+        *chunks,
+        [&](std::string_view track_name) {
+            return converter.is_track_used(track_name);
+        },
+        m_max_threads);
+    if (!midi) {
+        return midi.error();
+    }
+    if (auto exceeded = check_decoded_midi(limit_checker, *midi)) {
+        return std::move(*exceeded);
+    }
+    return converter.try_convert(*midi);
+}
+
+SightRead::Song
+SightRead::MidiParser::parse_file(const std::filesystem::path& path) const
+{
+    const SightRead::Detail::MappedFile file {path};
+    return parse(file.bytes());
 }
@@ -1,4 +1,8 @@
+#include <utility>
+
 #include "sightread/qbmidiparser.hpp"
+#include "sightread/detail/limitchecker.hpp"
+#include "sightread/detail/mappedfile.hpp"
 #include "sightread/detail/qbmidiconverter.hpp"
 
 namespace {
@@ -21,12 +25,41 @@ SightRead::QbMidiParser::QbMidiParser(SightRead::Metadata metadata,
 {
 }
 
+SightRead::QbMidiParser&
+SightRead::QbMidiParser::limits(SightRead::ParseLimits limits)
+{
+    m_limits = std::move(limits);
+    return *this;
+}
+
 SightRead::Song
 SightRead::QbMidiParser::parse(std::span<const std::uint8_t> data) const
 {
-    const auto qb_midi
-        = SightRead::Detail::parse_qb(data, endianness(m_console));
-    const auto converter
-        = SightRead::Detail::QbMidiConverter(m_metadata, m_short_name);
-    return converter.convert(qb_midi);
+    return try_parse(data).value();
+}
+
+SightRead::ParseResult<SightRead::Song>
+SightRead::QbMidiParser::try_parse(std::span<const std::uint8_t> data) const
+{
+    const SightRead::Detail::LimitChecker limit_checker {m_limits};
+    if (auto exceeded = limit_checker.check_payload(data.size())) {
+        return std::move(*exceeded);
+    }
+    // The reader counts events and checks the time budget as it goes, so
+    // files that claim to hold many elements are stopped early.
+    const auto qb_midi = SightRead::Detail::try_parse_qb(
+        data, endianness(m_console), limit_checker);
+    if (!qb_midi) {
+        return qb_midi.error();
+    }
+    return SightRead::Detail::QbMidiConverter(m_metadata, m_short_name)
+        .limit_checker(limit_checker)
+        .try_convert(*qb_midi);
+}
+
+SightRead::Song
+SightRead::QbMidiParser::parse_file(const std::filesystem::path& path) const
+{
+    const SightRead::Detail::MappedFile file {path};
+    return parse(file.bytes());
 }
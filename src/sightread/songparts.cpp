@@ -298,20 +298,26 @@ void SightRead::NoteTrack::generate_drum_fills(
     }
     const auto final_note_s = tempo_map.to_seconds(m_notes.back().position);
     const auto measure_bound = tempo_map.to_measures(final_note_s + FILL_DELAY);
+    // Measures are visited in order, so notes too early for one measure are
+    // too early for every later one and need not be scanned again.
+    auto first_close_note = note_times.cbegin();
     SightRead::Measure m {1.0};
     while (m <= measure_bound) {
         const auto fill_seconds = tempo_map.to_seconds(m);
         const auto measure_ticks = tempo_map.to_ticks(tempo_map.to_beats(m));
+        while (first_close_note != note_times.cend()
+               && std::get<0>(*first_close_note) - fill_seconds + FILL_DELAY
+                   < SightRead::Second {0}) {
+            ++first_close_note;
+        }
         bool exists_close_note = false;
         SightRead::Tick close_note_position {0};
-        for (const auto& [s, pos] : note_times) {
+        for (auto it = first_close_note; it != note_times.cend(); ++it) {
+            const auto& [s, pos] = *it;
             const auto s_diff = s - fill_seconds;
             if (s_diff > FILL_DELAY) {
                 break;
             }
-            if (s_diff + FILL_DELAY < SightRead::Second {0}) {
-                continue;
-            }
             if (!exists_close_note) {
                 exists_close_note = true;
                 close_note_position = pos;
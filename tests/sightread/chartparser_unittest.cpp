@@ -1,3 +1,6 @@
+#include <filesystem>
+#include <fstream>
+
 #include <boost/test/unit_test.hpp>
 
 #include "sightread/chartparser.hpp"
@@ -279,6 +282,43 @@ BOOST_AUTO_TEST_CASE(chart_header_values_besides_resolution_are_discarded)
     BOOST_CHECK_NE(song.global_data().charter(), "NotGMS");
 }
 
+BOOST_AUTO_TEST_CASE(sections_for_unpermitted_instruments_are_not_parsed)
+{
+    const auto guitar_track = section_string(
+        "ExpertSingle", {{.position = 768, .fret = 0, .length = 0}});
+    const auto chart_file
+        = guitar_track + "\n[ExpertDrums]\n{\n    768 = N 1\n}";
+
+    const auto song = SightRead::ChartParser({})
+                          .permit_instruments({SightRead::Instrument::Guitar})
+                          .parse(chart_file);
+
+    BOOST_CHECK_EQUAL(song.instruments().size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(chart_files_can_be_parsed_from_disk)
+{
+    const auto header = header_string({});
+    const auto guitar_track = section_string(
+        "ExpertSingle", {{.position = 768, .fret = 0, .length = 0}});
+    const auto chart_file = header + '\n' + guitar_track;
+    const auto path = std::filesystem::temp_directory_path()
+        / "sightread_chartparser_parse_file.chart";
+    {
+        std::ofstream file {path, std::ios::binary};
+        file << chart_file;
+    }
+
+    const auto song = SightRead::ChartParser({}).parse_file(path);
+    std::filesystem::remove(path);
+    const auto& notes = song.track(SightRead::Instrument::Guitar,
+                                   SightRead::Difficulty::Expert)
+                            .notes();
+
+    BOOST_CHECK_EQUAL(notes.size(), 1U);
+    BOOST_CHECK_EQUAL(notes.at(0).position, SightRead::Tick {768});
+}
+
 BOOST_AUTO_TEST_CASE(ini_values_are_used_for_converting_from_chart_files)
 {
     const auto header = header_string({});
@@ -1007,6 +1047,21 @@ BOOST_AUTO_TEST_CASE(disco_flips_without_closing_events_still_take_effect)
                       SightRead::FLAGS_DISCO | SightRead::FLAGS_DRUMS);
 }
 
+BOOST_AUTO_TEST_CASE(mix_events_without_a_trailing_d_do_not_start_disco_flips)
+{
+    const auto chart_file = section_string(
+        "ExpertDrums", {{.position = 192, .fret = 1, .length = 0}}, {},
+        {{.position = 192, .data = "mix_3_drums0e"},
+         {.position = 192, .data = "[mix_3_drums0d"}});
+
+    const auto song = SightRead::ChartParser({}).parse(chart_file);
+    const auto& track = song.track(SightRead::Instrument::Drums,
+                                   SightRead::Difficulty::Expert);
+    const auto& note = track.notes().at(0);
+
+    BOOST_CHECK_EQUAL(note.flags, SightRead::FLAGS_DRUMS);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_CASE(instruments_not_permitted_are_dropped_from_charts)
@@ -1307,3 +1362,290 @@ BOOST_AUTO_TEST_CASE(not_done_on_drums)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(charts_can_be_streamed)
+
+BOOST_AUTO_TEST_CASE(streamed_charts_match_parsed_charts)
+{
+    const auto header = header_string({{"Resolution", "480"}});
+    const auto guitar_track = section_string(
+        "ExpertSingle",
+        {{.position = 768, .fret = 0, .length = 0},
+         {.position = 960, .fret = 1, .length = 480}},
+        {{.position = 768, .key = 2, .length = 100}});
+    const auto chart_file = "\xEF\xBB\xBF" + header + '\n' + guitar_track;
+    const auto parsed_song = SightRead::ChartParser({}).parse(chart_file);
+
+    auto stream = SightRead::ChartParser({}).stream();
+    for (const auto c : chart_file) {
+        stream.push(std::string_view {&c, 1});
+    }
+    const auto song = stream.finish();
+
+    BOOST_CHECK_EQUAL(song.global_data().resolution(), 480);
+    const auto& notes = song.track(SightRead::Instrument::Guitar,
+                                   SightRead::Difficulty::Expert)
+                            .notes();
+    const auto& parsed_notes
+        = parsed_song
+              .track(SightRead::Instrument::Guitar,
+                     SightRead::Difficulty::Expert)
+              .notes();
+    BOOST_CHECK_EQUAL_COLLECTIONS(notes.cbegin(), notes.cend(),
+                                  parsed_notes.cbegin(), parsed_notes.cend());
+}
+
+BOOST_AUTO_TEST_CASE(streamed_utf16_charts_throw)
+{
+    auto stream = SightRead::ChartParser({}).stream();
+
+    BOOST_CHECK_THROW(stream.push("\xFF\xFE["), SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(streamed_latin1_charts_match_parsed_charts)
+{
+    using namespace std::string_literals;
+
+    const std::vector<SightRead::PracticeSection> expected_sections {
+        {.name = "Caf\u00E9"s, .start = SightRead::Tick {768}}};
+    const auto events = "[Events]\n{\n    768 = E \"section Caf\xE9\"\n}"s;
+    const auto guitar_track = section_string(
+        "ExpertSingle", {{.position = 768, .fret = 0, .length = 0}});
+    const auto chart_file = events + '\n' + guitar_track;
+    const auto parsed_song = SightRead::ChartParser({}).parse(chart_file);
+
+    auto stream = SightRead::ChartParser({}).stream();
+    for (const auto c : chart_file) {
+        stream.push(std::string_view {&c, 1});
+    }
+    const auto song = stream.finish();
+    const auto& practice_sections = song.global_data().practice_sections();
+    const auto& parsed_sections
+        = parsed_song.global_data().practice_sections();
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        practice_sections.cbegin(), practice_sections.cend(),
+        expected_sections.cbegin(), expected_sections.cend());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        practice_sections.cbegin(), practice_sections.cend(),
+        parsed_sections.cbegin(), parsed_sections.cend());
+}
+
+BOOST_AUTO_TEST_CASE(streamed_charts_mixing_utf8_and_latin1_throw)
+{
+    auto stream = SightRead::ChartParser({}).stream();
+    stream.push("[Events]\n{\n    768 = E \"section Caf\xC3\xA9\"\n}\n");
+
+    BOOST_CHECK_THROW(
+        stream.push("[Song]\n{\n  Name = \"Caf\xE9\"\n}\n"),
+        SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(streamed_charts_without_notes_throw)
+{
+    auto stream = SightRead::ChartParser({}).stream();
+    stream.push("[Song]\n{\nResolution = 192\n}\n");
+
+    BOOST_CHECK_THROW([&] { return stream.finish(); }(), SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(charts_can_be_parsed_in_parallel)
+
+BOOST_AUTO_TEST_CASE(parallel_parsing_matches_serial_parsing)
+{
+    const auto early_guitar_track = section_string(
+        "ExpertSingle",
+        {{.position = 0, .fret = 0, .length = 0},
+         {.position = 100, .fret = 1, .length = 700}});
+    const auto header = header_string({{"Resolution", "480"}});
+    std::string chart_file = early_guitar_track + '\n' + header;
+    for (const auto* name :
+         {"ExpertDrums", "HardSingle", "ExpertDoubleBass", "ExpertSingle"}) {
+        chart_file += '\n';
+        chart_file += section_string(
+            name,
+            {{.position = 768, .fret = 0, .length = 0},
+             {.position = 900, .fret = 1, .length = 960}});
+    }
+
+    const auto serial_song = SightRead::ChartParser({}).parse(chart_file);
+    const auto parallel_song
+        = SightRead::ChartParser({}).max_threads(4).parse(chart_file);
+
+    const auto instruments = parallel_song.instruments();
+    BOOST_CHECK_EQUAL(instruments.size(), 3U);
+    BOOST_CHECK(instruments == serial_song.instruments());
+    for (auto inst : instruments) {
+        for (auto diff : parallel_song.difficulties(inst)) {
+            const auto& serial_track = serial_song.track(inst, diff);
+            const auto& parallel_track = parallel_song.track(inst, diff);
+            BOOST_CHECK_EQUAL_COLLECTIONS(
+                parallel_track.notes().cbegin(), parallel_track.notes().cend(),
+                serial_track.notes().cbegin(), serial_track.notes().cend());
+            BOOST_CHECK_EQUAL(parallel_track.base_score(),
+                              serial_track.base_score());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(malformed_charts_throw_when_parsed_in_parallel)
+{
+    const auto guitar_track = section_string(
+        "ExpertSingle", {{.position = 768, .fret = 0, .length = 0}});
+    const auto chart_file = guitar_track + "\n[ExpertDrums]\n{\n768 = N 0 0\n";
+
+    BOOST_CHECK_THROW(
+        [&] {
+            return SightRead::ChartParser({}).max_threads(4).parse(chart_file);
+        }(),
+        SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(charts_can_be_parsed_without_throwing)
+
+BOOST_AUTO_TEST_CASE(valid_charts_give_a_song)
+{
+    const auto chart_file = section_string(
+        "ExpertSingle", {{.position = 768, .fret = 0, .length = 0}});
+
+    const auto result = SightRead::ChartParser({}).try_parse(chart_file);
+
+    BOOST_REQUIRE(result.has_value());
+    BOOST_CHECK_EQUAL(result
+                          ->track(SightRead::Instrument::Guitar,
+                                  SightRead::Difficulty::Expert)
+                          .notes()
+                          .size(),
+                      1U);
+}
+
+BOOST_AUTO_TEST_CASE(malformed_lines_are_reported_with_their_byte_offset)
+{
+    const std::string chart_file {
+        "\xEF\xBB\xBF[ExpertSingle]\n{\n768 = N 0 0\n768 = N 0\n}"};
+
+    for (const auto max_threads : {1U, 4U}) {
+        const auto result = SightRead::ChartParser({})
+                                .max_threads(max_threads)
+                                .try_parse(chart_file);
+
+        BOOST_REQUIRE(!result.has_value());
+        BOOST_CHECK(result.error().category
+                    == SightRead::ParseErrorCategory::Syntax);
+        BOOST_CHECK(result.error().byte_offset == 32U);
+        BOOST_CHECK_EQUAL(result.error().message, "Line incomplete");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(charts_without_notes_are_reported_as_content_errors)
+{
+    const auto result
+        = SightRead::ChartParser({}).try_parse("[Song]\n{\nResolution = x\n}");
+
+    BOOST_REQUIRE(!result.has_value());
+    BOOST_CHECK(result.error().category
+                == SightRead::ParseErrorCategory::Content);
+    BOOST_CHECK(!result.error().byte_offset.has_value());
+}
+
+BOOST_AUTO_TEST_CASE(odd_length_utf16_charts_are_reported_as_encoding_errors)
+{
+    const std::string chart_file {"\xFF\xFE\x5B\x00\x53", 5};
+
+    const auto result = SightRead::ChartParser({}).try_parse(chart_file);
+
+    BOOST_REQUIRE(!result.has_value());
+    BOOST_CHECK(result.error().category
+                == SightRead::ParseErrorCategory::Encoding);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(parse_limits)
+
+BOOST_AUTO_TEST_CASE(charts_within_limits_are_parsed)
+{
+    const auto chart_file = section_string(
+        "ExpertSingle", {{.position = 768, .fret = 0, .length = 0}});
+
+    const auto song = SightRead::ChartParser({})
+                          .limits({.max_payload_bytes = chart_file.size(),
+                                   .max_sections = 1,
+                                   .max_tracks = std::nullopt,
+                                   .max_events = 1,
+                                   .time_budget = std::chrono::hours {1}})
+                          .parse(chart_file);
+
+    BOOST_CHECK_EQUAL(song.instruments().size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(exceeding_a_limit_throws_parse_limit_error)
+{
+    const auto chart_file
+        = section_string("ExpertSingle",
+                         {{.position = 768, .fret = 0, .length = 0}})
+        + '\n'
+        + section_string("ExpertDrums",
+                         {{.position = 768, .fret = 0, .length = 0}});
+
+    SightRead::ParseLimits limits;
+    limits.max_sections = 1;
+
+    BOOST_CHECK_THROW(
+        [&] {
+            return SightRead::ChartParser({}).limits(limits).parse(chart_file);
+        }(),
+        SightRead::ParseLimitError);
+}
+
+BOOST_AUTO_TEST_CASE(exceeded_limits_are_reported_by_try_parse)
+{
+    const auto chart_file = section_string(
+        "ExpertSingle",
+        {{.position = 768, .fret = 0, .length = 0},
+         {.position = 960, .fret = 0, .length = 0}});
+
+    SightRead::ParseLimits event_limits;
+    event_limits.max_events = 1;
+    SightRead::ParseLimits payload_limits;
+    payload_limits.max_payload_bytes = chart_file.size() - 1;
+
+    const auto event_result
+        = SightRead::ChartParser({}).limits(event_limits).try_parse(chart_file);
+    const auto payload_result = SightRead::ChartParser({})
+                                    .limits(payload_limits)
+                                    .try_parse(chart_file);
+
+    BOOST_REQUIRE(!event_result.has_value());
+    BOOST_CHECK(event_result.error().category
+                == SightRead::ParseErrorCategory::LimitExceeded);
+    BOOST_REQUIRE(!payload_result.has_value());
+    BOOST_CHECK(payload_result.error().category
+                == SightRead::ParseErrorCategory::LimitExceeded);
+}
+
+BOOST_AUTO_TEST_CASE(limits_apply_to_streamed_charts)
+{
+    const auto chart_file = section_string(
+        "ExpertSingle",
+        {{.position = 768, .fret = 0, .length = 0},
+         {.position = 960, .fret = 0, .length = 0}});
+
+    SightRead::ParseLimits limits;
+    limits.max_events = 1;
+
+    auto parser = SightRead::ChartParser({}).limits(limits).stream();
+
+    BOOST_CHECK_THROW(
+        [&] {
+            parser.push(chart_file);
+            return parser.finish();
+        }(),
+        SightRead::ParseLimitError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
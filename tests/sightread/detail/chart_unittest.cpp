@@ -1,4 +1,8 @@
+#include <functional>
+#include <string>
+#include <string_view>
 #include <tuple>
+#include <utility>
 
 #include <boost/test/unit_test.hpp>
 
@@ -98,7 +102,8 @@ BOOST_AUTO_TEST_CASE(lone_carriage_return_does_not_break_line)
 {
     const char* text = "[Section]\r\n{\r\nKey = Value\rOops\r\n}";
 
-    const auto section = SightRead::Detail::parse_chart(text).sections.at(0);
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
 
     BOOST_CHECK_EQUAL(section.key_value_pairs.size(), 1U);
     BOOST_CHECK_EQUAL(section.key_value_pairs.at("Key"), "Value\rOops");
@@ -108,7 +113,8 @@ BOOST_AUTO_TEST_CASE(key_value_pairs_are_read)
 {
     const char* text = "[Section]\n{\nKey = Value\nKey2 = Value2\n}";
 
-    const auto section = SightRead::Detail::parse_chart(text).sections.at(0);
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
 
     BOOST_CHECK_EQUAL(section.key_value_pairs.size(), 2U);
     BOOST_CHECK_EQUAL(section.key_value_pairs.at("Key"), "Value");
@@ -121,7 +127,8 @@ BOOST_AUTO_TEST_CASE(note_events_are_read)
     const std::vector<SightRead::Detail::NoteEvent> events {
         {.position = 1000, .fret = 1, .length = 0}};
 
-    const auto section = SightRead::Detail::parse_chart(text).sections.at(0);
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
 
     BOOST_CHECK_EQUAL_COLLECTIONS(section.note_events.cbegin(),
                                   section.note_events.cend(), events.cbegin(),
@@ -144,7 +151,8 @@ BOOST_AUTO_TEST_CASE(bpm_events_are_read)
     const std::vector<SightRead::Detail::BpmEvent> events {
         {.position = 1000, .bpm = 150000}};
 
-    const auto section = SightRead::Detail::parse_chart(text).sections.at(0);
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
 
     BOOST_CHECK_EQUAL_COLLECTIONS(section.bpm_events.cbegin(),
                                   section.bpm_events.cend(), events.cbegin(),
@@ -158,7 +166,8 @@ BOOST_AUTO_TEST_CASE(timesig_events_are_read)
         {.position = 1000, .numerator = 4, .denominator = 2},
         {.position = 2000, .numerator = 3, .denominator = 3}};
 
-    const auto section = SightRead::Detail::parse_chart(text).sections.at(0);
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
 
     BOOST_CHECK_EQUAL_COLLECTIONS(section.ts_events.cbegin(),
                                   section.ts_events.cend(), events.cbegin(),
@@ -171,7 +180,8 @@ BOOST_AUTO_TEST_CASE(special_events_are_read)
     const std::vector<SightRead::Detail::SpecialEvent> events {
         {.position = 1000, .key = 2, .length = 700}};
 
-    const auto section = SightRead::Detail::parse_chart(text).sections.at(0);
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
 
     BOOST_CHECK_EQUAL_COLLECTIONS(section.special_events.cbegin(),
                                   section.special_events.cend(),
@@ -184,18 +194,87 @@ BOOST_AUTO_TEST_CASE(e_events_are_read)
     const std::vector<SightRead::Detail::Event> events {
         {.position = 1000, .data = "soloing"}};
 
-    const auto section = SightRead::Detail::parse_chart(text).sections.at(0);
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
 
     BOOST_CHECK_EQUAL_COLLECTIONS(section.events.cbegin(),
                                   section.events.cend(), events.cbegin(),
                                   events.cend());
 }
 
+BOOST_AUTO_TEST_CASE(e_events_keep_all_their_spaces)
+{
+    const char* text = "[Section]\n{\n1000 = E lyric  two words \n}";
+    const std::vector<SightRead::Detail::Event> events {
+        {.position = 1000, .data = "lyric  two words "}};
+
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(section.events.cbegin(),
+                                  section.events.cend(), events.cbegin(),
+                                  events.cend());
+}
+
+BOOST_AUTO_TEST_CASE(tokens_after_the_note_length_are_ignored)
+{
+    const char* text = "[Section]\n{\n1000 = N 1 0 2 3\n}";
+    const std::vector<SightRead::Detail::NoteEvent> events {
+        {.position = 1000, .fret = 1, .length = 0}};
+
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(section.note_events.cbegin(),
+                                  section.note_events.cend(), events.cbegin(),
+                                  events.cend());
+}
+
+BOOST_AUTO_TEST_CASE(spaces_in_key_value_pair_values_are_dropped)
+{
+    const char* text = "[Section]\n{\nName = \"Two Words\"\n}";
+
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
+
+    BOOST_CHECK_EQUAL(section.key_value_pairs.at("Name"), "\"TwoWords\"");
+}
+
+BOOST_AUTO_TEST_CASE(event_text_and_key_value_pairs_view_the_chart_text)
+{
+    const std::string_view text
+        = "[Section]\n{\nKey = Value\n1000 = E lyric text\n}";
+
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
+    const auto text_range = std::less_equal<> {};
+
+    const auto& [key, value] = *section.key_value_pairs.begin();
+    BOOST_TEST(text_range(text.data(), key.data()));
+    BOOST_TEST(text_range(value.data(), text.data() + text.size()));
+    const auto& event_text = section.events.at(0).data;
+    BOOST_CHECK_EQUAL(static_cast<const void*>(event_text.data()),
+                      static_cast<const void*>(text.data() + 33));
+}
+
+BOOST_AUTO_TEST_CASE(values_with_spaces_survive_moving_their_section)
+{
+    const std::string text {"[Section]\n{\nName = Two Words\n}"};
+
+    const auto section = [&] {
+        auto chart = SightRead::Detail::parse_chart(text);
+        return std::move(chart.sections.at(0));
+    }();
+
+    BOOST_CHECK_EQUAL(section.key_value_pairs.at("Name"), "TwoWords");
+}
+
 BOOST_AUTO_TEST_CASE(other_events_are_ignored)
 {
     const char* text = "[Section]\n{\n1105 = A 133\n}";
 
-    const auto section = SightRead::Detail::parse_chart(text).sections.at(0);
+    const auto chart = SightRead::Detail::parse_chart(text);
+    const auto& section = chart.sections.at(0);
 
     BOOST_TEST(section.note_events.empty());
     BOOST_TEST(section.note_events.empty());
@@ -226,3 +305,131 @@ BOOST_AUTO_TEST_CASE(errant_quote_character_in_song_does_not_cause_a_throw)
         return SightRead::Detail::parse_chart("[Song]\n{\nName=\"Days\n\"\n}");
     }());
 }
+
+BOOST_AUTO_TEST_CASE(sections_not_passing_filter_are_skipped_unparsed)
+{
+    const char* text = "[Song]\n{\n}\n[ExpertDrums]\n{\n1 = N 1\n}\n"
+                       "[ExpertSingle]\n{\n768 = N 0 0\n}";
+
+    const auto chart = SightRead::Detail::parse_chart(
+        text, [](auto name) { return name != "ExpertDrums"; });
+
+    BOOST_CHECK_EQUAL(chart.sections.size(), 2U);
+    BOOST_CHECK_EQUAL(chart.sections.at(0).name, "Song");
+    BOOST_CHECK_EQUAL(chart.sections.at(1).name, "ExpertSingle");
+    BOOST_CHECK_EQUAL(chart.sections.at(1).note_events.size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(sections_parsed_in_parallel_keep_their_order)
+{
+    std::string text;
+    for (auto i = 0; i < 20; ++i) {
+        text += "[Section" + std::to_string(i) + "]\n{\n" + std::to_string(i)
+            + " = N 0 0\n}\n";
+    }
+
+    const auto chart = SightRead::Detail::parse_chart(text, {}, 4);
+
+    BOOST_REQUIRE_EQUAL(chart.sections.size(), 20U);
+    for (auto i = 0; i < 20; ++i) {
+        const auto& section = chart.sections.at(static_cast<std::size_t>(i));
+        BOOST_CHECK_EQUAL(section.name, "Section" + std::to_string(i));
+        BOOST_CHECK_EQUAL(section.note_events.at(0).position, i);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(chart_section_reader)
+
+BOOST_AUTO_TEST_CASE(sections_are_returned_once_their_closing_line_ends)
+{
+    SightRead::Detail::ChartSectionReader reader;
+
+    BOOST_TEST(reader.push("[SectionA]\n{\nKey = Value\n}").empty());
+    const auto sections = reader.push("\n[SectionB]\n{\n");
+
+    BOOST_CHECK_EQUAL(sections.size(), 1U);
+    BOOST_CHECK_EQUAL(sections.at(0).name, "SectionA");
+    BOOST_CHECK_EQUAL(sections.at(0).key_value_pairs.at("Key"), "Value");
+}
+
+BOOST_AUTO_TEST_CASE(sections_match_parse_chart_however_input_is_split)
+{
+    const std::string_view text
+        = "[Song]\r\n{\r\n  Resolution = 192\r\n}\r\n\r\n[ExpertSingle]\r\n{"
+          "\r\n  768 = N 0 0\r\n  768 = E }\r\n}";
+    const auto expected = SightRead::Detail::parse_chart(text).sections;
+
+    for (auto split = 0U; split <= text.size(); ++split) {
+        SightRead::Detail::ChartSectionReader reader;
+        auto section_count = 0U;
+        // Sections only view their text until the next call to the reader, so
+        // each batch is checked as soon as it is returned.
+        const auto check_sections = [&](const auto& sections) {
+            for (const auto& section : sections) {
+                BOOST_REQUIRE_LT(section_count, expected.size());
+                const auto& expected_section = expected[section_count];
+                BOOST_CHECK_EQUAL(section.name, expected_section.name);
+                BOOST_CHECK(section.key_value_pairs
+                            == expected_section.key_value_pairs);
+                BOOST_CHECK_EQUAL_COLLECTIONS(
+                    section.note_events.cbegin(), section.note_events.cend(),
+                    expected_section.note_events.cbegin(),
+                    expected_section.note_events.cend());
+                BOOST_CHECK_EQUAL(section.events.size(),
+                                  expected_section.events.size());
+                ++section_count;
+            }
+        };
+        check_sections(reader.push(text.substr(0, split)));
+        check_sections(reader.push(text.substr(split)));
+        check_sections(reader.finish());
+
+        BOOST_CHECK_EQUAL(section_count, expected.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(short_sections_pushed_in_small_pieces_are_read_intact)
+{
+    const std::string_view text = "[Song]\n\t{\n}\n\t\n[Events]\n{\n}\n";
+    const std::vector<std::string> expected_names {"Song", "Events"};
+
+    for (auto piece_size = 1U; piece_size <= text.size(); ++piece_size) {
+        SightRead::Detail::ChartSectionReader reader;
+        std::vector<std::string> names;
+        for (auto i = 0U; i < text.size(); i += piece_size) {
+            for (const auto& section :
+                 reader.push(text.substr(i, piece_size))) {
+                names.emplace_back(section.name);
+            }
+        }
+        for (const auto& section : reader.finish()) {
+            names.emplace_back(section.name);
+        }
+
+        BOOST_CHECK_EQUAL_COLLECTIONS(names.cbegin(), names.cend(),
+                                      expected_names.cbegin(),
+                                      expected_names.cend());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sections_not_passing_filter_are_skipped)
+{
+    SightRead::Detail::ChartSectionReader reader {
+        [](auto name) { return name != "ExpertDrums"; }};
+
+    const auto sections
+        = reader.push("[ExpertDrums]\n{\n1 = N 1\n}\n[Song]\n{\n}\n");
+
+    BOOST_CHECK_EQUAL(sections.size(), 1U);
+    BOOST_CHECK_EQUAL(sections.at(0).name, "Song");
+}
+
+BOOST_AUTO_TEST_CASE(unfinished_sections_throw_when_input_ends)
+{
+    SightRead::Detail::ChartSectionReader reader;
+    reader.push("[Song]\n{\n}\n[ExpertSingle]\n{\n");
+
+    BOOST_CHECK_THROW([&] { return reader.finish(); }(), SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include <boost/test/unit_test.hpp>
+
+#include "sightread/detail/mappedfile.hpp"
+
+namespace {
+class TemporaryFile {
+private:
+    std::filesystem::path m_path;
+
+public:
+    TemporaryFile(const std::string& name, std::string_view contents)
+        : m_path {std::filesystem::temp_directory_path() / name}
+    {
+        std::ofstream file {m_path, std::ios::binary};
+        file.write(contents.data(),
+                   static_cast<std::streamsize>(contents.size()));
+    }
+    ~TemporaryFile() { std::filesystem::remove(m_path); }
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+    TemporaryFile(TemporaryFile&&) = delete;
+    TemporaryFile& operator=(TemporaryFile&&) = delete;
+
+    [[nodiscard]] const std::filesystem::path& path() const { return m_path; }
+};
+}
+
+BOOST_AUTO_TEST_SUITE(mapped_file)
+
+BOOST_AUTO_TEST_CASE(file_contents_are_mapped)
+{
+    const TemporaryFile file {"sightread_mappedfile_contents.bin",
+                              std::string_view {"ab\0c", 4}};
+    const SightRead::Detail::MappedFile mapped_file {file.path()};
+
+    BOOST_CHECK_EQUAL(mapped_file.chars(), (std::string_view {"ab\0c", 4}));
+    BOOST_CHECK_EQUAL(mapped_file.bytes().size(), 4U);
+    BOOST_CHECK_EQUAL(mapped_file.bytes()[3], 'c');
+}
+
+BOOST_AUTO_TEST_CASE(empty_files_can_be_mapped)
+{
+    const TemporaryFile file {"sightread_mappedfile_empty.bin", ""};
+    const SightRead::Detail::MappedFile mapped_file {file.path()};
+
+    BOOST_TEST(mapped_file.bytes().empty());
+    BOOST_TEST(mapped_file.chars().empty());
+}
+
+BOOST_AUTO_TEST_CASE(missing_files_throw)
+{
+    const auto path = std::filesystem::temp_directory_path()
+        / "sightread_mappedfile_missing.bin";
+    std::filesystem::remove(path);
+
+    BOOST_CHECK_THROW([&] { return SightRead::Detail::MappedFile {path}; }(),
+                      std::filesystem::filesystem_error);
+}
+
+BOOST_AUTO_TEST_CASE(directories_throw)
+{
+    const auto path = std::filesystem::temp_directory_path();
+
+    BOOST_CHECK_THROW([&] { return SightRead::Detail::MappedFile {path}; }(),
+                      std::filesystem::filesystem_error);
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE(fifos_throw_instead_of_mapping_as_empty)
+{
+    const auto path = std::filesystem::temp_directory_path()
+        / "sightread_mappedfile_fifo";
+    std::filesystem::remove(path);
+    BOOST_REQUIRE_EQUAL(mkfifo(path.c_str(), 0600), 0);
+
+    BOOST_CHECK_THROW([&] { return SightRead::Detail::MappedFile {path}; }(),
+                      std::filesystem::filesystem_error);
+    std::filesystem::remove(path);
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,21 +1,24 @@
+#include <algorithm>
+#include <array>
 #include <tuple>
 
 #include <boost/test/unit_test.hpp>
 
 #include "sightread/detail/midi.hpp"
+#include "sightread/midiparser.hpp"
 #include "sightread/tempomap.hpp"
 
 namespace SightRead::Detail {
 bool operator==(const MetaEvent& lhs, const MetaEvent& rhs)
 {
-    return std::tie(lhs.type, lhs.data) == std::tie(rhs.type, rhs.data);
+    return lhs.type == rhs.type && std::ranges::equal(lhs.data, rhs.data);
 }
 
 std::ostream& operator<<(std::ostream& stream, const MetaEvent& event)
 {
     stream << "{Type " << event.type << ", Data {";
     for (auto i = 0U; i < event.data.size(); ++i) {
-        stream << static_cast<unsigned int>(event.data.at(i));
+        stream << static_cast<unsigned int>(event.data[i]);
         if (i + 1 != event.data.size()) {
             stream << ", ";
         }
@@ -39,14 +42,14 @@ std::ostream& operator<<(std::ostream& stream, const MidiEvent& event)
 
 bool operator==(const SysexEvent& lhs, const SysexEvent& rhs)
 {
-    return lhs.data == rhs.data;
+    return std::ranges::equal(lhs.data, rhs.data);
 }
 
 std::ostream& operator<<(std::ostream& stream, const SysexEvent& event)
 {
     stream << "{Data {";
     for (auto i = 0U; i < event.data.size(); ++i) {
-        stream << static_cast<unsigned int>(event.data.at(i));
+        stream << static_cast<unsigned int>(event.data[i]);
         if (i + 1 != event.data.size()) {
             stream << ", ";
         }
@@ -128,8 +131,8 @@ BOOST_AUTO_TEST_CASE(track_lengths_are_read_correctly)
     const auto midi = SightRead::Detail::parse_midi(data);
 
     BOOST_CHECK_EQUAL(midi.tracks.size(), 2U);
-    BOOST_TEST(midi.tracks.at(0).events.empty());
-    BOOST_CHECK_EQUAL(midi.tracks.at(1).events.size(), 1U);
+    BOOST_TEST(midi.tracks.at(0).size() == 0);
+    BOOST_CHECK_EQUAL(midi.tracks.at(1).size(), 1U);
 }
 
 BOOST_AUTO_TEST_CASE(track_magic_number_is_checked)
@@ -141,6 +144,20 @@ BOOST_AUTO_TEST_CASE(track_magic_number_is_checked)
                       SightRead::ParseError);
 }
 
+BOOST_AUTO_TEST_CASE(bad_track_chunks_are_reported_with_their_offset)
+{
+    std::vector<std::uint8_t> track_one {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 0};
+    std::vector<std::uint8_t> bad_track {0x40, 0x54, 0x72, 0x6B, 0, 0, 0, 0};
+    auto data = midi_from_tracks({track_one, bad_track});
+
+    const auto chunks = SightRead::Detail::find_midi_chunks(data);
+
+    BOOST_REQUIRE(!chunks.has_value());
+    BOOST_CHECK(chunks.error().category
+                == SightRead::ParseErrorCategory::Syntax);
+    BOOST_CHECK_EQUAL(chunks.error().byte_offset.value_or(0), 22U);
+}
+
 BOOST_AUTO_TEST_CASE(extra_tracks_in_header_are_ignored)
 {
     std::vector<std::uint8_t> track_one {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 0};
@@ -152,8 +169,29 @@ BOOST_AUTO_TEST_CASE(extra_tracks_in_header_are_ignored)
     const auto midi = SightRead::Detail::parse_midi(data);
 
     BOOST_CHECK_EQUAL(midi.tracks.size(), 2U);
-    BOOST_TEST(midi.tracks.at(0).events.empty());
-    BOOST_CHECK_EQUAL(midi.tracks.at(1).events.size(), 1U);
+    BOOST_TEST(midi.tracks.at(0).size() == 0);
+    BOOST_CHECK_EQUAL(midi.tracks.at(1).size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(track_limits_are_checked_before_tracks_are_decoded)
+{
+    std::vector<std::uint8_t> track_one {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 0};
+    std::vector<std::uint8_t> bad_track {0x4D, 0x54, 0x72, 0x6B, 0,    0,
+                                         0,    8,    0x8F, 0x8F, 0x8F, 0x8F,
+                                         0x10, 0xFF, 2,    0};
+    const auto data = midi_from_tracks({track_one, bad_track});
+    SightRead::ParseLimits limits;
+    limits.max_tracks = 1;
+
+    const auto result
+        = SightRead::MidiParser({}).limits(limits).try_parse(data);
+
+    BOOST_REQUIRE(!result.has_value());
+    BOOST_CHECK(result.error().category
+                == SightRead::ParseErrorCategory::LimitExceeded);
+    BOOST_CHECK_THROW(
+        [&] { return SightRead::MidiParser({}).limits(limits).parse(data); }(),
+        SightRead::ParseLimitError);
 }
 
 BOOST_AUTO_TEST_SUITE(event_times_are_handled_correctly)
@@ -166,7 +204,7 @@ BOOST_AUTO_TEST_CASE(multi_byte_delta_times_are_parsed_correctly)
 
     const auto midi = SightRead::Detail::parse_midi(data);
 
-    BOOST_CHECK_EQUAL(midi.tracks.at(0).events.at(0).time, 0x790);
+    BOOST_CHECK_EQUAL(midi.tracks.at(0).events().at(0).time, 0x790);
 }
 
 BOOST_AUTO_TEST_CASE(times_are_absolute_not_delta_times)
@@ -177,7 +215,7 @@ BOOST_AUTO_TEST_CASE(times_are_absolute_not_delta_times)
 
     const auto midi = SightRead::Detail::parse_midi(data);
 
-    BOOST_CHECK_EQUAL(midi.tracks.at(0).events.at(1).time, 0x60);
+    BOOST_CHECK_EQUAL(midi.tracks.at(0).events().at(1).time, 0x60);
 }
 
 BOOST_AUTO_TEST_CASE(five_byte_multi_byte_delta_times_throw)
@@ -190,6 +228,20 @@ BOOST_AUTO_TEST_CASE(five_byte_multi_byte_delta_times_throw)
                       SightRead::ParseError);
 }
 
+BOOST_AUTO_TEST_CASE(bad_delta_times_are_reported_with_their_offset)
+{
+    std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0,    0,    0, 8,
+                                     0x8F, 0x8F, 0x8F, 0x8F, 0x10, 0xFF, 2, 0};
+    const auto data = midi_from_tracks({track});
+
+    const auto result = SightRead::MidiParser({}).try_parse(data);
+
+    BOOST_REQUIRE(!result.has_value());
+    BOOST_CHECK(result.error().category
+                == SightRead::ParseErrorCategory::Syntax);
+    BOOST_CHECK_EQUAL(result.error().byte_offset.value_or(0), 25U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(meta_events_are_read)
@@ -199,15 +251,15 @@ BOOST_AUTO_TEST_CASE(simple_meta_event_is_read)
     std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0, 0,    0,   7,
                                      0x60, 0xFF, 0x51, 3,    8, 0x6B, 0xC3};
     auto data = midi_from_tracks({track});
+    const std::array<std::uint8_t, 3> tempo {8, 0x6B, 0xC3};
     std::vector<SightRead::Detail::TimedEvent> events {
         {.time = 0x60,
-         .event = SightRead::Detail::MetaEvent {.type = 0x51,
-                                                .data = {8, 0x6B, 0xC3}}}};
+         .event = SightRead::Detail::MetaEvent {.type = 0x51, .data = tempo}}};
 
     const auto midi = SightRead::Detail::parse_midi(data);
+    const auto parsed_events = midi.tracks.at(0).events();
 
-    BOOST_CHECK_EQUAL_COLLECTIONS(midi.tracks.at(0).events.cbegin(),
-                                  midi.tracks.at(0).events.cend(),
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed_events.cbegin(), parsed_events.cend(),
                                   events.cbegin(), events.cend());
 }
 
@@ -216,15 +268,15 @@ BOOST_AUTO_TEST_CASE(meta_event_with_multi_byte_length_is_read)
     std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0,    8,
                                      0x60, 0xFF, 0x51, 0x80, 3, 8, 0x6B, 0xC3};
     const auto data = midi_from_tracks({track});
+    const std::array<std::uint8_t, 3> tempo {8, 0x6B, 0xC3};
     std::vector<SightRead::Detail::TimedEvent> events {
         {.time = 0x60,
-         .event = SightRead::Detail::MetaEvent {.type = 0x51,
-                                                .data = {8, 0x6B, 0xC3}}}};
+         .event = SightRead::Detail::MetaEvent {.type = 0x51, .data = tempo}}};
 
     const auto midi = SightRead::Detail::parse_midi(data);
+    const auto parsed_events = midi.tracks.at(0).events();
 
-    BOOST_CHECK_EQUAL_COLLECTIONS(midi.tracks.at(0).events.cbegin(),
-                                  midi.tracks.at(0).events.cend(),
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed_events.cbegin(), parsed_events.cend(),
                                   events.cbegin(), events.cend());
 }
 
@@ -254,9 +306,9 @@ BOOST_AUTO_TEST_CASE(a_single_event_is_read)
                                                 .data = {0x7F, 0x64}}}};
 
     const auto midi = SightRead::Detail::parse_midi(data);
+    const auto parsed_events = midi.tracks.at(0).events();
 
-    BOOST_CHECK_EQUAL_COLLECTIONS(midi.tracks.at(0).events.cbegin(),
-                                  midi.tracks.at(0).events.cend(),
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed_events.cbegin(), parsed_events.cend(),
                                   events.cbegin(), events.cend());
 }
 
@@ -274,9 +326,9 @@ BOOST_AUTO_TEST_CASE(running_status_is_parsed)
                                                 .data = {0x7F, 0x64}}}};
 
     const auto midi = SightRead::Detail::parse_midi(data);
+    const auto parsed_events = midi.tracks.at(0).events();
 
-    BOOST_CHECK_EQUAL_COLLECTIONS(midi.tracks.at(0).events.cbegin(),
-                                  midi.tracks.at(0).events.cend(),
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed_events.cbegin(), parsed_events.cend(),
                                   events.cbegin(), events.cend());
 }
 
@@ -308,7 +360,29 @@ BOOST_AUTO_TEST_CASE(not_all_midi_events_take_two_data_bytes)
 
     const auto midi = SightRead::Detail::parse_midi(data);
 
-    BOOST_CHECK_EQUAL(midi.tracks.at(0).events.size(), 2U);
+    BOOST_CHECK_EQUAL(midi.tracks.at(0).size(), 2U);
+}
+
+BOOST_AUTO_TEST_CASE(midi_events_are_stored_apart_from_other_events)
+{
+    std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0,    0, 0,
+                                     11,   0,    0x94, 0x7F, 0x64, 0x10, 0xFF,
+                                     2,    0,    0x10, 0x7F, 0x64};
+    auto data = midi_from_tracks({track});
+    const std::vector<int> times {0, 0x20};
+    const std::vector<int> indices {0, 2};
+
+    const auto midi = SightRead::Detail::parse_midi(data);
+    const auto& parsed_track = midi.tracks.at(0);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed_track.midi_times.cbegin(),
+                                  parsed_track.midi_times.cend(),
+                                  times.cbegin(), times.cend());
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed_track.midi_indices.cbegin(),
+                                  parsed_track.midi_indices.cend(),
+                                  indices.cbegin(), indices.cend());
+    BOOST_CHECK_EQUAL(parsed_track.meta_events.size(), 1U);
+    BOOST_CHECK_EQUAL(parsed_track.meta_events.at(0).index, 1);
 }
 
 BOOST_AUTO_TEST_CASE(midi_events_with_status_byte_high_nibble_f_throw)
@@ -330,13 +404,14 @@ BOOST_AUTO_TEST_CASE(simple_sysex_event_is_read)
     std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0,
                                      6,    0x0,  0xF0, 3,    1, 2, 3};
     const auto data = midi_from_tracks({track});
+    const std::array<std::uint8_t, 3> message {1, 2, 3};
     std::vector<SightRead::Detail::TimedEvent> events {
-        {.time = 0, .event = SightRead::Detail::SysexEvent {{1, 2, 3}}}};
+        {.time = 0, .event = SightRead::Detail::SysexEvent {message}}};
 
     const auto midi = SightRead::Detail::parse_midi(data);
+    const auto parsed_events = midi.tracks.at(0).events();
 
-    BOOST_CHECK_EQUAL_COLLECTIONS(midi.tracks.at(0).events.cbegin(),
-                                  midi.tracks.at(0).events.cend(),
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed_events.cbegin(), parsed_events.cend(),
                                   events.cbegin(), events.cend());
 }
 
@@ -345,13 +420,14 @@ BOOST_AUTO_TEST_CASE(sysex_event_with_multi_byte_length_is_read)
     std::vector<std::uint8_t> track {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 7,
                                      0x0,  0xF0, 0x80, 3,    1, 2, 3};
     const auto data = midi_from_tracks({track});
+    const std::array<std::uint8_t, 3> message {1, 2, 3};
     std::vector<SightRead::Detail::TimedEvent> events {
-        {.time = 0, .event = SightRead::Detail::SysexEvent {{1, 2, 3}}}};
+        {.time = 0, .event = SightRead::Detail::SysexEvent {message}}};
 
     const auto midi = SightRead::Detail::parse_midi(data);
+    const auto parsed_events = midi.tracks.at(0).events();
 
-    BOOST_CHECK_EQUAL_COLLECTIONS(midi.tracks.at(0).events.cbegin(),
-                                  midi.tracks.at(0).events.cend(),
+    BOOST_CHECK_EQUAL_COLLECTIONS(parsed_events.cbegin(), parsed_events.cend(),
                                   events.cbegin(), events.cend());
 }
 
@@ -366,3 +442,109 @@ BOOST_AUTO_TEST_CASE(sysex_event_with_too_high_length_throws)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(track_filter_is_respected)
+
+BOOST_AUTO_TEST_CASE(tracks_rejected_by_the_filter_are_skipped)
+{
+    std::vector<std::uint8_t> first_track {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 0};
+    std::vector<std::uint8_t> wanted_track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 5, 0, 0xFF, 3, 1, 'A'};
+    std::vector<std::uint8_t> unwanted_track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 5, 0, 0xFF, 3, 1, 'B'};
+    const auto data
+        = midi_from_tracks({first_track, unwanted_track, wanted_track});
+
+    const auto midi = SightRead::Detail::parse_midi(
+        data, [](std::string_view name) { return name == "A"; });
+
+    BOOST_CHECK_EQUAL(midi.tracks.size(), 2U);
+    BOOST_TEST(midi.tracks.at(0).size() == 0);
+    BOOST_CHECK_EQUAL(midi.tracks.at(1).size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(events_after_the_name_of_skipped_tracks_are_not_decoded)
+{
+    std::vector<std::uint8_t> first_track {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 0};
+    std::vector<std::uint8_t> unwanted_track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 9, 0, 0xFF, 3, 1, 'B', 0, 0xF0, 0, 0};
+    const auto data = midi_from_tracks({first_track, unwanted_track});
+
+    const auto midi = SightRead::Detail::parse_midi(
+        data, [](std::string_view name) { return name == "A"; });
+
+    BOOST_CHECK_EQUAL(midi.tracks.size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(first_track_is_kept_and_unnamed_tracks_are_dropped)
+{
+    std::vector<std::uint8_t> unnamed_track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 4, 0, 0xFF, 2, 0};
+    const auto data = midi_from_tracks({unnamed_track, unnamed_track});
+
+    const auto midi = SightRead::Detail::parse_midi(
+        data, [](std::string_view) { return true; });
+
+    BOOST_CHECK_EQUAL(midi.tracks.size(), 1U);
+    BOOST_CHECK_EQUAL(midi.tracks.at(0).size(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(tracks_decoded_in_parallel_keep_their_order)
+{
+    std::vector<std::uint8_t> first_track {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 0};
+    std::vector<std::vector<std::uint8_t>> tracks {first_track};
+    for (std::uint8_t name = 'A'; name <= 'H'; ++name) {
+        tracks.push_back(
+            {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 5, 0, 0xFF, 3, 1, name});
+    }
+    const auto data = midi_from_tracks(tracks);
+    const auto filter = [](std::string_view name) { return name != "C"; };
+
+    const auto serial_midi = SightRead::Detail::parse_midi(data, filter);
+    const auto parallel_midi = SightRead::Detail::parse_midi(data, filter, 4);
+
+    BOOST_CHECK_EQUAL(parallel_midi.tracks.size(), 8U);
+    BOOST_CHECK_EQUAL(parallel_midi.tracks.size(), serial_midi.tracks.size());
+    for (auto i = 0U; i < parallel_midi.tracks.size(); ++i) {
+        const auto parallel_events = parallel_midi.tracks.at(i).events();
+        const auto serial_events = serial_midi.tracks.at(i).events();
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            parallel_events.cbegin(), parallel_events.cend(),
+            serial_events.cbegin(), serial_events.cend());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(errors_in_parallel_decoding_are_reported)
+{
+    std::vector<std::uint8_t> first_track {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 0};
+    std::vector<std::uint8_t> named_track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 5, 0, 0xFF, 3, 1, 'A'};
+    std::vector<std::uint8_t> bad_track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 4, 0, 0xF0, 100, 1};
+    const auto data
+        = midi_from_tracks({first_track, named_track, bad_track, named_track});
+
+    BOOST_CHECK_THROW(
+        [&] {
+            return SightRead::Detail::parse_midi(
+                data, [](std::string_view) { return true; }, 4);
+        }(),
+        SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(track_chunks_longer_than_the_file_throw)
+{
+    std::vector<std::uint8_t> first_track {0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 0};
+    std::vector<std::uint8_t> long_track {
+        0x4D, 0x54, 0x72, 0x6B, 0, 0, 0, 100, 0, 0xFF, 3, 1, 'B'};
+    const auto data = midi_from_tracks({first_track, long_track});
+
+    BOOST_CHECK_THROW(
+        [&] {
+            return SightRead::Detail::parse_midi(
+                data, [](std::string_view) { return false; });
+        }(),
+        SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
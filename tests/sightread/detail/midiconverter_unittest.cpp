@@ -1,3 +1,7 @@
+#include <chrono>
+#include <deque>
+#include <thread>
+
 #include <boost/test/unit_test.hpp>
 
 #include "sightread/detail/midiconverter.hpp"
@@ -23,16 +27,24 @@ guitar_only_converter(SightRead::HopoThreshold hopo_threshold = {},
         .permit_instruments({SightRead::Instrument::Guitar});
 }
 
+// Meta and sysex event data does not own its bytes, so the bytes of events
+// made for tests are kept alive here.
+std::span<const std::uint8_t> payload(std::vector<std::uint8_t> bytes)
+{
+    static std::deque<std::vector<std::uint8_t>> storage;
+    return storage.emplace_back(std::move(bytes));
+}
+
 SightRead::Detail::MetaEvent part_event(std::string_view name)
 {
-    std::vector<std::uint8_t> bytes {name.cbegin(), name.cend()};
-    return SightRead::Detail::MetaEvent {.type = 3, .data = bytes};
+    return SightRead::Detail::MetaEvent {
+        .type = 3, .data = payload({name.cbegin(), name.cend()})};
 }
 
 SightRead::Detail::MetaEvent text_event(std::string_view text)
 {
-    std::vector<std::uint8_t> bytes {text.cbegin(), text.cend()};
-    return SightRead::Detail::MetaEvent {.type = 1, .data = bytes};
+    return SightRead::Detail::MetaEvent {
+        .type = 1, .data = payload({text.cbegin(), text.cend()})};
 }
 }
 
@@ -76,11 +88,11 @@ BOOST_AUTO_TEST_CASE(tempos_are_read_correctly)
 {
     SightRead::Detail::MidiTrack tempo_track {
         {{.time = 0,
-          .event = {SightRead::Detail::MetaEvent {.type = 0x51,
-                                                  .data = {6, 0x1A, 0x80}}}},
+          .event = {SightRead::Detail::MetaEvent {
+              .type = 0x51, .data = payload({6, 0x1A, 0x80})}}},
          {.time = 1920,
-          .event = {SightRead::Detail::MetaEvent {.type = 0x51,
-                                                  .data = {4, 0x93, 0xE0}}}}}};
+          .event = {SightRead::Detail::MetaEvent {
+              .type = 0x51, .data = payload({4, 0x93, 0xE0})}}}}};
     const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
                                         .tracks = {tempo_track}};
     const std::vector<SightRead::BPM> bpms {
@@ -99,8 +111,8 @@ BOOST_AUTO_TEST_CASE(too_short_tempo_events_cause_an_exception)
 {
     SightRead::Detail::MidiTrack tempo_track {
         {{.time = 0,
-          .event
-          = {SightRead::Detail::MetaEvent {.type = 0x51, .data = {6, 0x1A}}}}}};
+          .event = {SightRead::Detail::MetaEvent {
+              .type = 0x51, .data = payload({6, 0x1A})}}}}};
     const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
                                         .tracks = {tempo_track}};
     const SightRead::Detail::MidiConverter converter {{}};
@@ -113,11 +125,11 @@ BOOST_AUTO_TEST_CASE(time_signatures_are_read_correctly)
 {
     SightRead::Detail::MidiTrack ts_track {
         {{.time = 0,
-          .event = {SightRead::Detail::MetaEvent {.type = 0x58,
-                                                  .data = {6, 2, 24, 8}}}},
+          .event = {SightRead::Detail::MetaEvent {
+              .type = 0x58, .data = payload({6, 2, 24, 8})}}},
          {.time = 1920,
-          .event = {SightRead::Detail::MetaEvent {.type = 0x58,
-                                                  .data = {3, 3, 24, 8}}}}}};
+          .event = {SightRead::Detail::MetaEvent {
+              .type = 0x58, .data = payload({3, 3, 24, 8})}}}}};
     const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
                                         .tracks = {ts_track}};
     const std::vector<SightRead::TimeSignature> tses {
@@ -136,8 +148,8 @@ BOOST_AUTO_TEST_CASE(time_signatures_with_large_denominators_cause_an_exception)
 {
     SightRead::Detail::MidiTrack ts_track {
         {{.time = 0,
-          .event = {SightRead::Detail::MetaEvent {.type = 0x58,
-                                                  .data = {6, 32, 24, 8}}}}}};
+          .event = {SightRead::Detail::MetaEvent {
+              .type = 0x58, .data = payload({6, 32, 24, 8})}}}}};
     const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
                                         .tracks = {ts_track}};
     const SightRead::Detail::MidiConverter converter {{}};
@@ -150,8 +162,8 @@ BOOST_AUTO_TEST_CASE(too_short_time_sig_events_cause_an_exception)
 {
     SightRead::Detail::MidiTrack ts_track {
         {{.time = 0,
-          .event
-          = {SightRead::Detail::MetaEvent {.type = 0x58, .data = {6}}}}}};
+          .event = {SightRead::Detail::MetaEvent {
+              .type = 0x58, .data = payload({6})}}}}};
     const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
                                         .tracks = {ts_track}};
     const SightRead::Detail::MidiConverter converter {{}};
@@ -169,8 +181,8 @@ BOOST_AUTO_TEST_CASE(loss_of_precision_reading_bpms_is_negligible)
 {
     SightRead::Detail::MidiTrack tempo_track {
         {{.time = 0,
-          .event = {SightRead::Detail::MetaEvent {.type = 0x51,
-                                                  .data = {7, 0xA1, 0x22}}}}}};
+          .event = {SightRead::Detail::MetaEvent {
+              .type = 0x51, .data = payload({7, 0xA1, 0x22})}}}}};
     const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 480,
                                         .tracks = {tempo_track}};
 
@@ -187,7 +199,7 @@ BOOST_AUTO_TEST_CASE(song_name_is_not_read_from_midi)
     SightRead::Detail::MidiTrack name_track {
         {{.time = 0,
           .event = {SightRead::Detail::MetaEvent {
-              .type = 1, .data = {72, 101, 108, 108, 111}}}}}};
+              .type = 1, .data = payload({72, 101, 108, 108, 111})}}}}};
     const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
                                         .tracks = {name_track}};
 
@@ -402,7 +414,7 @@ BOOST_AUTO_TEST_CASE(part_guitar_event_need_not_be_the_first_event)
     SightRead::Detail::MidiTrack note_track {
         {{.time = 0,
           .event = {SightRead::Detail::MetaEvent {
-              .type = 0x7F, .data = {0x05, 0x0F, 0x09, 0x08, 0x40}}}},
+              .type = 0x7F, .data = payload({0x05, 0x0F, 0x09, 0x08, 0x40})}}},
          {.time = 0, .event = {part_event("PART GUITAR")}},
          {.time = 768,
           .event
@@ -423,6 +435,37 @@ BOOST_AUTO_TEST_CASE(part_guitar_event_need_not_be_the_first_event)
         1 << SightRead::FIVE_FRET_RED);
 }
 
+BOOST_AUTO_TEST_CASE(only_the_first_track_with_a_given_name_is_read)
+{
+    SightRead::Detail::MidiTrack first_track {
+        {{.time = 0, .event = {part_event("PART GUITAR")}},
+         {.time = 768,
+          .event
+          = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {97, 64}}}},
+         {.time = 960,
+          .event
+          = {SightRead::Detail::MidiEvent {.status = 0x80, .data = {97, 0}}}}}};
+    SightRead::Detail::MidiTrack second_track {
+        {{.time = 0, .event = {part_event("PART GUITAR")}},
+         {.time = 768,
+          .event
+          = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 64}}}},
+         {.time = 960,
+          .event
+          = {SightRead::Detail::MidiEvent {.status = 0x80, .data = {96, 0}}}}}};
+    const SightRead::Detail::Midi midi {
+        .ticks_per_quarter_note = 192,
+        .tracks = {{}, first_track, second_track}};
+
+    const auto song = guitar_only_converter().convert(midi);
+    const auto& track = song.track(SightRead::Instrument::Guitar,
+                                   SightRead::Difficulty::Expert);
+
+    BOOST_CHECK_EQUAL(track.notes().size(), 1U);
+    BOOST_CHECK_EQUAL(track.notes().at(0).colours(),
+                      1 << SightRead::FIVE_FRET_RED);
+}
+
 BOOST_AUTO_TEST_CASE(guitar_notes_are_also_read_from_t1_gems)
 {
     SightRead::Detail::MidiTrack other_track {
@@ -576,10 +619,10 @@ BOOST_AUTO_TEST_CASE(open_notes_are_read_correctly)
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 64}}}},
          {.time = 768,
           .event = {SightRead::Detail::SysexEvent {
-              {0x50, 0x53, 0, 0, 3, 1, 1, 0xF7}}}},
+              payload({0x50, 0x53, 0, 0, 3, 1, 1, 0xF7})}}},
          {.time = 770,
           .event = {SightRead::Detail::SysexEvent {
-              {0x50, 0x53, 0, 0, 3, 1, 0, 0xF7}}}},
+              payload({0x50, 0x53, 0, 0, 3, 1, 0, 0xF7})}}},
          {.time = 960,
           .event
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 0}}}}}};
@@ -605,10 +648,10 @@ BOOST_AUTO_TEST_CASE(length_zero_open_events_are_handled_correctly)
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 64}}}},
          {.time = 768,
           .event = {SightRead::Detail::SysexEvent {
-              {0x50, 0x53, 0, 0, 3, 1, 1, 0xF7}}}},
+              payload({0x50, 0x53, 0, 0, 3, 1, 1, 0xF7})}}},
          {.time = 768,
           .event = {SightRead::Detail::SysexEvent {
-              {0x50, 0x53, 0, 0, 3, 1, 0, 0xF7}}}},
+              payload({0x50, 0x53, 0, 0, 3, 1, 0, 0xF7})}}},
          {.time = 960,
           .event
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 0}}}}}};
@@ -634,7 +677,7 @@ BOOST_AUTO_TEST_CASE(parseerror_thrown_if_open_note_ons_have_no_note_offs)
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 64}}}},
          {.time = 768,
           .event = {SightRead::Detail::SysexEvent {
-              {0x50, 0x53, 0, 0, 3, 1, 1, 0xF7}}}},
+              payload({0x50, 0x53, 0, 0, 3, 1, 1, 0xF7})}}},
          {.time = 960,
           .event
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 0}}}}}};
@@ -803,6 +846,29 @@ BOOST_AUTO_TEST_CASE(solos_are_read_from_mids_correctly)
                                   solos.cbegin(), solos.cend());
 }
 
+BOOST_AUTO_TEST_CASE(conversion_stops_once_the_time_budget_runs_out)
+{
+    SightRead::Detail::MidiTrack note_track {
+        {{.time = 0, .event = {part_event("PART GUITAR")}},
+         {.time = 768,
+          .event
+          = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 64}}}},
+         {.time = 960,
+          .event
+          = {SightRead::Detail::MidiEvent {.status = 0x80, .data = {96, 0}}}}}};
+    const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
+                                        .tracks = {note_track}};
+    SightRead::ParseLimits limits;
+    limits.time_budget = std::chrono::steady_clock::duration::zero();
+    const SightRead::Detail::LimitChecker limit_checker {limits};
+    std::this_thread::sleep_for(std::chrono::milliseconds {1});
+
+    const auto converter = guitar_only_converter().limit_checker(limit_checker);
+
+    BOOST_CHECK_THROW([&] { return converter.convert(midi); }(),
+                      SightRead::ParseLimitError);
+}
+
 BOOST_AUTO_TEST_SUITE(star_power_is_read)
 
 BOOST_AUTO_TEST_CASE(a_single_phrase_is_read)
@@ -1367,10 +1433,10 @@ BOOST_AUTO_TEST_CASE(tap_note_sysex_events_are_read_correctly)
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 64}}}},
          {.time = 768,
           .event = {SightRead::Detail::SysexEvent {
-              {0x50, 0x53, 0, 0, 3, 4, 1, 0xF7}}}},
+              payload({0x50, 0x53, 0, 0, 3, 4, 1, 0xF7})}}},
          {.time = 770,
           .event = {SightRead::Detail::SysexEvent {
-              {0x50, 0x53, 0, 0, 3, 4, 0, 0xF7}}}},
+              payload({0x50, 0x53, 0, 0, 3, 4, 0, 0xF7})}}},
          {.time = 960,
           .event
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 0}}}}}};
@@ -1397,10 +1463,10 @@ BOOST_AUTO_TEST_CASE(tap_note_sysex_events_spanning_all_diffs_are_handled)
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 64}}}},
          {.time = 768,
           .event = {SightRead::Detail::SysexEvent {
-              {0x50, 0x53, 0, 0, 3, 4, 1, 0xF7}}}},
+              payload({0x50, 0x53, 0, 0, 3, 4, 1, 0xF7})}}},
          {.time = 770,
           .event = {SightRead::Detail::SysexEvent {
-              {0x50, 0x53, 0, 0, 0xFF, 4, 0, 0xF7}}}},
+              payload({0x50, 0x53, 0, 0, 0xFF, 4, 0, 0xF7})}}},
          {.time = 960,
           .event
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {96, 0}}}}}};
@@ -2017,8 +2083,9 @@ BOOST_AUTO_TEST_CASE(disco_flips_are_read_correctly)
          {.time = 15,
           .event = {SightRead::Detail::MetaEvent {
               .type = 1,
-              .data = {0x5B, 0x6D, 0x69, 0x78, 0x20, 0x33, 0x20, 0x64, 0x72,
-                       0x75, 0x6D, 0x73, 0x30, 0x64, 0x5D}}}},
+              .data = payload(
+                  {0x5B, 0x6D, 0x69, 0x78, 0x20, 0x33, 0x20, 0x64, 0x72,
+                   0x75, 0x6D, 0x73, 0x30, 0x64, 0x5D})}}},
          {.time = 45,
           .event
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {98, 64}}}},
@@ -2028,8 +2095,9 @@ BOOST_AUTO_TEST_CASE(disco_flips_are_read_correctly)
          {.time = 75,
           .event = {SightRead::Detail::MetaEvent {
               .type = 1,
-              .data = {0x5B, 0x6D, 0x69, 0x78, 0x20, 0x33, 0x20, 0x64, 0x72,
-                       0x75, 0x6D, 0x73, 0x30, 0x5D}}}}}};
+              .data = payload(
+                  {0x5B, 0x6D, 0x69, 0x78, 0x20, 0x33, 0x20, 0x64, 0x72,
+                   0x75, 0x6D, 0x73, 0x30, 0x5D})}}}}};
     const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
                                         .tracks = {note_track}};
     const auto song = drums_only_converter().convert(midi);
@@ -2049,8 +2117,9 @@ BOOST_AUTO_TEST_CASE(disco_flips_with_underscores_are_read_correctly)
          {.time = 15,
           .event = {SightRead::Detail::MetaEvent {
               .type = 1,
-              .data = {0x5B, 0x6D, 0x69, 0x78, 0x5F, 0x33, 0x5F, 0x64, 0x72,
-                       0x75, 0x6D, 0x73, 0x30, 0x64, 0x5D}}}},
+              .data = payload(
+                  {0x5B, 0x6D, 0x69, 0x78, 0x5F, 0x33, 0x5F, 0x64, 0x72,
+                   0x75, 0x6D, 0x73, 0x30, 0x64, 0x5D})}}},
          {.time = 45,
           .event
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {98, 64}}}},
@@ -2060,8 +2129,9 @@ BOOST_AUTO_TEST_CASE(disco_flips_with_underscores_are_read_correctly)
          {.time = 75,
           .event = {SightRead::Detail::MetaEvent {
               .type = 1,
-              .data = {0x5B, 0x6D, 0x69, 0x78, 0x5F, 0x33, 0x5F, 0x64, 0x72,
-                       0x75, 0x6D, 0x73, 0x30, 0x5D}}}}}};
+              .data = payload(
+                  {0x5B, 0x6D, 0x69, 0x78, 0x5F, 0x33, 0x5F, 0x64, 0x72,
+                   0x75, 0x6D, 0x73, 0x30, 0x5D})}}}}};
     const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
                                         .tracks = {note_track}};
     const auto song = drums_only_converter().convert(midi);
@@ -2082,8 +2152,9 @@ BOOST_AUTO_TEST_CASE(
          {.time = 15,
           .event = {SightRead::Detail::MetaEvent {
               .type = 1,
-              .data = {0x5B, 0x6D, 0x69, 0x78, 0x20, 0x33, 0x20, 0x64, 0x72,
-                       0x75, 0x6D, 0x73, 0x30, 0x64, 0x5D}}}},
+              .data = payload(
+                  {0x5B, 0x6D, 0x69, 0x78, 0x20, 0x33, 0x20, 0x64, 0x72,
+                   0x75, 0x6D, 0x73, 0x30, 0x64, 0x5D})}}},
          {.time = 45,
           .event
           = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {98, 64}}}},
@@ -2102,6 +2173,28 @@ BOOST_AUTO_TEST_CASE(
                           | SightRead::FLAGS_DRUMS);
 }
 
+BOOST_AUTO_TEST_CASE(disco_flips_for_unknown_difficulties_are_ignored)
+{
+    SightRead::Detail::MidiTrack note_track {
+        {{.time = 0, .event = {part_event("PART DRUMS")}},
+         {.time = 15, .event = {text_event("[mix 7 drums0d]")}},
+         {.time = 45,
+          .event
+          = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {98, 64}}}},
+         {.time = 65,
+          .event
+          = {SightRead::Detail::MidiEvent {.status = 0x80, .data = {98, 0}}}}}};
+    const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
+                                        .tracks = {note_track}};
+    const auto song = drums_only_converter().convert(midi);
+    const auto& track = song.track(SightRead::Instrument::Drums,
+                                   SightRead::Difficulty::Expert);
+    const auto& note = track.notes().at(0);
+
+    BOOST_CHECK_EQUAL(note.flags,
+                      SightRead::FLAGS_CYMBAL | SightRead::FLAGS_DRUMS);
+}
+
 BOOST_AUTO_TEST_CASE(drum_five_lane_to_four_lane_conversion_is_done_from_mid)
 {
     SightRead::Detail::MidiTrack note_track {
@@ -2286,6 +2379,30 @@ BOOST_AUTO_TEST_CASE(ENABLE_CHART_DYNAMICS_works_without_braces)
                                   notes.cbegin(), notes.cend());
 }
 
+BOOST_AUTO_TEST_CASE(ENABLE_CHART_DYNAMICS_applies_to_earlier_notes)
+{
+    SightRead::Detail::MidiTrack note_track {
+        {{.time = 0, .event = {part_event("PART DRUMS")}},
+         {.time = 0,
+          .event
+          = {SightRead::Detail::MidiEvent {.status = 0x90, .data = {97, 1}}}},
+         {.time = 1,
+          .event
+          = {SightRead::Detail::MidiEvent {.status = 0x80, .data = {97, 0}}}},
+         {.time = 2, .event = {text_event("[ENABLE_CHART_DYNAMICS]")}}}};
+    const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
+                                        .tracks = {note_track}};
+    const auto song = drums_only_converter().convert(midi);
+    const auto& track = song.track(SightRead::Instrument::Drums,
+                                   SightRead::Difficulty::Expert);
+
+    std::vector<SightRead::Note> notes {make_drum_note(
+        0, 0, SightRead::DRUM_RED, SightRead::NoteFlags::FLAGS_GHOST)};
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(track.notes().cbegin(), track.notes().cend(),
+                                  notes.cbegin(), notes.cend());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_CASE(instruments_not_permitted_are_dropped_from_midis)
@@ -2417,3 +2534,49 @@ BOOST_AUTO_TEST_CASE(fortnite_instrument_notes_are_separated)
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_CASE(only_tracks_used_by_the_converter_are_marked_as_used)
+{
+    const auto converter = guitar_only_converter();
+
+    BOOST_TEST(converter.is_track_used("PART GUITAR"));
+    BOOST_TEST(converter.is_track_used("T1 GEMS"));
+    BOOST_TEST(converter.is_track_used("EVENTS"));
+    BOOST_TEST(converter.is_track_used("BEAT"));
+    BOOST_TEST(!converter.is_track_used("PART DRUMS"));
+    BOOST_TEST(!converter.is_track_used("VENUE"));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_conversion_matches_serial_conversion)
+{
+    std::vector<SightRead::Detail::MidiTrack> tracks {{}};
+    for (const auto* name : {"PART GUITAR", "PART BASS", "PART DRUMS"}) {
+        tracks.push_back(SightRead::Detail::MidiTrack {
+            {{.time = 0, .event = {part_event(name)}},
+             {.time = 768,
+              .event = {SightRead::Detail::MidiEvent {.status = 0x90,
+                                                      .data = {97, 64}}}},
+             {.time = 960,
+              .event = {SightRead::Detail::MidiEvent {.status = 0x80,
+                                                      .data = {97, 0}}}}}});
+    }
+    const SightRead::Detail::Midi midi {.ticks_per_quarter_note = 192,
+                                        .tracks = tracks};
+
+    const auto serial_song = SightRead::Detail::MidiConverter({}).convert(midi);
+    const auto parallel_song
+        = SightRead::Detail::MidiConverter({}).max_threads(4).convert(midi);
+
+    const auto instruments = parallel_song.instruments();
+    BOOST_CHECK_EQUAL(instruments.size(), 3U);
+    BOOST_CHECK(instruments == serial_song.instruments());
+    for (auto inst : instruments) {
+        const auto& serial_notes
+            = serial_song.track(inst, SightRead::Difficulty::Expert).notes();
+        const auto& parallel_notes
+            = parallel_song.track(inst, SightRead::Difficulty::Expert).notes();
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            parallel_notes.cbegin(), parallel_notes.cend(),
+            serial_notes.cbegin(), serial_notes.cend());
+    }
+}
@@ -0,0 +1,307 @@
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "qbtesthelpers.hpp"
+#include "sightread/detail/qbmidi.hpp"
+
+namespace {
+constexpr std::array<SightRead::Detail::Endianness, 2> ENDIANNESSES {
+    SightRead::Detail::Endianness::LittleEndian,
+    SightRead::Detail::Endianness::BigEndian};
+
+std::vector<std::uint32_t>
+to_vector(const SightRead::Detail::QbIntegers& integers)
+{
+    return std::visit(
+        [](const auto& view) {
+            return std::vector<std::uint32_t> {view.begin(), view.end()};
+        },
+        integers);
+}
+
+const SightRead::Detail::QbArray&
+item_array(const SightRead::Detail::QbMidi& midi, std::string_view key)
+{
+    const auto* item = midi.item_by_id(qb_crc(key));
+    BOOST_REQUIRE(item != nullptr);
+    const auto* array = midi.array(item->data);
+    BOOST_REQUIRE(array != nullptr);
+    return *array;
+}
+
+std::vector<std::uint32_t>
+array_integers(const SightRead::Detail::QbMidi& midi,
+               const SightRead::Detail::QbArray* array)
+{
+    BOOST_REQUIRE(array != nullptr);
+    const auto integers = midi.integers(*array);
+    BOOST_REQUIRE(integers.has_value());
+    return to_vector(*integers);
+}
+
+std::vector<std::uint32_t> item_integers(const SightRead::Detail::QbMidi& midi,
+                                         std::string_view key)
+{
+    return array_integers(midi, &item_array(midi, key));
+}
+}
+
+BOOST_AUTO_TEST_CASE(integer_arrays_are_read_in_either_endianness)
+{
+    const std::vector<std::uint32_t> values {1, 0x01020304, 0xFFFFFFFF};
+
+    for (auto endianness : ENDIANNESSES) {
+        const auto data = QbFileBuilder {endianness}
+                              .integer_array("one", {7})
+                              .integer_array("many", values)
+                              .bytes();
+
+        const auto midi = SightRead::Detail::parse_qb(data, endianness);
+
+        BOOST_CHECK_EQUAL(midi.items.size(), 2U);
+        const std::vector<std::uint32_t> expected_one {7};
+        const auto read_one = item_integers(midi, "one");
+        BOOST_CHECK_EQUAL_COLLECTIONS(read_one.cbegin(), read_one.cend(),
+                                      expected_one.cbegin(),
+                                      expected_one.cend());
+        const auto read_many = item_integers(midi, "many");
+        BOOST_CHECK_EQUAL_COLLECTIONS(read_many.cbegin(), read_many.cend(),
+                                      values.cbegin(), values.cend());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(empty_arrays_have_no_integers)
+{
+    const auto data = QbFileBuilder {SightRead::Detail::Endianness::BigEndian}
+                          .integer_array("empty", {})
+                          .bytes();
+
+    const auto midi = SightRead::Detail::parse_qb(
+        data, SightRead::Detail::Endianness::BigEndian);
+
+    BOOST_TEST(item_integers(midi, "empty").empty());
+}
+
+BOOST_AUTO_TEST_CASE(nested_arrays_are_read)
+{
+    for (auto endianness : ENDIANNESSES) {
+        const auto data
+            = QbFileBuilder {endianness}
+                  .nested_integer_arrays("nested", {{0, 4, 4}, {1000, 3, 4}})
+                  .integer_array("after", {5})
+                  .bytes();
+
+        const auto midi = SightRead::Detail::parse_qb(data, endianness);
+        const auto& nested = item_array(midi, "nested");
+
+        BOOST_REQUIRE_EQUAL(nested.size, 2U);
+        const auto second
+            = array_integers(midi, midi.array_element(nested, 1));
+        const std::vector<std::uint32_t> expected_second {1000, 3, 4};
+        BOOST_CHECK_EQUAL_COLLECTIONS(second.cbegin(), second.cend(),
+                                      expected_second.cbegin(),
+                                      expected_second.cend());
+        BOOST_CHECK_EQUAL(item_integers(midi, "after").at(0), 5U);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(struct_items_are_read)
+{
+    const auto data
+        = QbFileBuilder {SightRead::Detail::Endianness::BigEndian}
+              .markers("markers",
+                       {{.time_ms = 500, .name = u"Intro"},
+                        {.time_ms = 1500, .name = std::uint32_t {0x001B546E}}})
+              .bytes();
+
+    const auto midi = SightRead::Detail::parse_qb(
+        data, SightRead::Detail::Endianness::BigEndian);
+    const auto& markers = item_array(midi, "markers");
+
+    BOOST_REQUIRE_EQUAL(markers.size, 2U);
+    const auto* first_struct = midi.struct_element(markers, 0);
+    BOOST_REQUIRE(first_struct != nullptr);
+    const auto first_items = midi.items_of(*first_struct);
+    BOOST_REQUIRE_EQUAL(first_items.size(), 2U);
+    BOOST_CHECK_EQUAL(SightRead::Detail::qb_value_as<std::int32_t>(
+                          first_items[0].props.value)
+                          .value_or(0),
+                      500);
+    const auto* first_name = midi.wide_string(first_items[1].data);
+    BOOST_REQUIRE(first_name != nullptr);
+    BOOST_CHECK(*first_name == u"Intro");
+    const auto* second_struct = midi.struct_element(markers, 1);
+    BOOST_REQUIRE(second_struct != nullptr);
+    const auto second_items = midi.items_of(*second_struct);
+    BOOST_REQUIRE_EQUAL(second_items.size(), 2U);
+    BOOST_CHECK_EQUAL(SightRead::Detail::qb_value_as<std::uint32_t>(
+                          second_items[1].data)
+                          .value_or(0),
+                      0x001B546EU);
+}
+
+BOOST_AUTO_TEST_CASE(first_item_with_an_id_is_found)
+{
+    const auto data = QbFileBuilder {SightRead::Detail::Endianness::BigEndian}
+                          .integer_array("key", {1})
+                          .integer_array("key", {2})
+                          .bytes();
+
+    const auto midi = SightRead::Detail::parse_qb(
+        data, SightRead::Detail::Endianness::BigEndian);
+
+    BOOST_CHECK_EQUAL(item_integers(midi, "key").at(0), 1U);
+    BOOST_CHECK(midi.item_by_id(qb_crc("missing")) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(values_of_the_wrong_type_are_not_returned)
+{
+    const auto data = QbFileBuilder {SightRead::Detail::Endianness::BigEndian}
+                          .integer_array("key", {1})
+                          .bytes();
+
+    const auto midi = SightRead::Detail::parse_qb(
+        data, SightRead::Detail::Endianness::BigEndian);
+    const auto* item = midi.item_by_id(qb_crc("key"));
+    BOOST_REQUIRE(item != nullptr);
+
+    BOOST_CHECK(midi.wide_string(item->data) == nullptr);
+    BOOST_CHECK(midi.array_element(item_array(midi, "key"), 0) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(malformed_files_throw_parse_errors)
+{
+    constexpr auto FIRST_ITEM_TYPE_OFFSET = 30;
+
+    const auto data = QbFileBuilder {SightRead::Detail::Endianness::BigEndian}
+                          .integer_array("key", {1, 2, 3})
+                          .bytes();
+    auto unknown_type = data;
+    unknown_type.at(FIRST_ITEM_TYPE_OFFSET) = 0x7F;
+    const std::vector<std::uint8_t> truncated {data.cbegin(),
+                                               std::prev(data.cend())};
+
+    for (const auto& bad_data : {unknown_type, truncated}) {
+        BOOST_CHECK_THROW(
+            [&] {
+                return SightRead::Detail::parse_qb(
+                    bad_data, SightRead::Detail::Endianness::BigEndian);
+            }(),
+            SightRead::ParseError);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(malformed_files_are_reported_with_their_offset)
+{
+    constexpr auto FIRST_ITEM_OFFSET = 28;
+    constexpr auto FIRST_ITEM_TYPE_OFFSET = 30;
+
+    const auto data = QbFileBuilder {SightRead::Detail::Endianness::BigEndian}
+                          .integer_array("key", {1, 2, 3})
+                          .bytes();
+    auto unknown_type = data;
+    unknown_type.at(FIRST_ITEM_TYPE_OFFSET) = 0x7F;
+    const std::vector<std::uint8_t> truncated {data.cbegin(),
+                                               std::prev(data.cend())};
+
+    const auto unknown_result = SightRead::Detail::try_parse_qb(
+        unknown_type, SightRead::Detail::Endianness::BigEndian);
+    const auto truncated_result = SightRead::Detail::try_parse_qb(
+        truncated, SightRead::Detail::Endianness::BigEndian);
+
+    BOOST_REQUIRE(!unknown_result.has_value());
+    BOOST_CHECK(unknown_result.error().category
+                == SightRead::ParseErrorCategory::Syntax);
+    BOOST_CHECK_EQUAL(unknown_result.error().byte_offset.value_or(0),
+                      FIRST_ITEM_OFFSET);
+    BOOST_REQUIRE(!truncated_result.has_value());
+    BOOST_TEST(truncated_result.error().byte_offset.has_value());
+    BOOST_TEST(*truncated_result.error().byte_offset <= truncated.size());
+}
+
+BOOST_AUTO_TEST_CASE(cyclic_struct_items_are_reported_with_their_offset)
+{
+    constexpr auto LAST_ITEM_OFFSET = 84;
+    constexpr auto LAST_NEXT_ITEM_OFFSET = 99;
+
+    auto data = QbFileBuilder {SightRead::Detail::Endianness::BigEndian}
+                    .markers("markers",
+                             {{.time_ms = 0, .name = std::uint32_t {1}}})
+                    .bytes();
+    data.at(LAST_NEXT_ITEM_OFFSET) = LAST_ITEM_OFFSET;
+
+    const auto result = SightRead::Detail::try_parse_qb(
+        data, SightRead::Detail::Endianness::BigEndian);
+
+    BOOST_REQUIRE(!result.has_value());
+    BOOST_CHECK(result.error().category
+                == SightRead::ParseErrorCategory::Syntax);
+    BOOST_CHECK_EQUAL(result.error().byte_offset.value_or(0),
+                      LAST_ITEM_OFFSET);
+    BOOST_CHECK_EQUAL(result.error().message,
+                      "QB offset points to data already read");
+}
+
+BOOST_AUTO_TEST_CASE(self_nested_arrays_are_reported_with_their_offset)
+{
+    constexpr auto ARRAY_OFFSET = 48;
+    constexpr auto LIST_START_OFFSET = 59;
+
+    auto data = QbFileBuilder {SightRead::Detail::Endianness::BigEndian}
+                    .nested_integer_arrays("nested", {{1, 2}})
+                    .bytes();
+    data.at(LIST_START_OFFSET) = ARRAY_OFFSET;
+
+    const auto result = SightRead::Detail::try_parse_qb(
+        data, SightRead::Detail::Endianness::BigEndian);
+
+    BOOST_REQUIRE(!result.has_value());
+    BOOST_CHECK(result.error().category
+                == SightRead::ParseErrorCategory::Syntax);
+    BOOST_CHECK_EQUAL(result.error().byte_offset.value_or(0), ARRAY_OFFSET);
+    BOOST_CHECK_EQUAL(result.error().message,
+                      "QB offset points to data already read");
+}
+
+BOOST_AUTO_TEST_CASE(deeply_nested_arrays_are_rejected)
+{
+    constexpr std::uint32_t NESTING_DEPTH = 1000;
+    constexpr std::uint8_t ARRAY_TYPE = 12;
+
+    std::vector<std::uint8_t> data(28);
+    const auto write = [&](std::uint32_t value) {
+        for (auto shift : {24U, 16U, 8U, 0U}) {
+            data.push_back(static_cast<std::uint8_t>(value >> shift));
+        }
+    };
+    const auto write_array_info = [&] {
+        data.insert(data.end(), {0, 0, ARRAY_TYPE, 0});
+    };
+    write_array_info();
+    write(qb_crc("nested"));
+    write(0);
+    write(0);
+    write(0);
+    // Each array holds one array, which starts straight after it.
+    for (auto i = 0U; i < NESTING_DEPTH; ++i) {
+        write_array_info();
+        write(1);
+        write(static_cast<std::uint32_t>(data.size() + 4));
+    }
+
+    const auto result = SightRead::Detail::try_parse_qb(
+        data, SightRead::Detail::Endianness::BigEndian);
+
+    BOOST_REQUIRE(!result.has_value());
+    BOOST_CHECK(result.error().category
+                == SightRead::ParseErrorCategory::Syntax);
+    BOOST_TEST(result.error().byte_offset.has_value());
+    BOOST_CHECK_EQUAL(result.error().message,
+                      "QB nodes are nested too deeply");
+}
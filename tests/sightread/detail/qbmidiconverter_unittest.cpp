@@ -0,0 +1,287 @@
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "qbtesthelpers.hpp"
+#include "sightread/detail/qbmidi.hpp"
+#include "sightread/detail/qbmidiconverter.hpp"
+#include "sightread/qbmidiparser.hpp"
+#include "testhelpers.hpp"
+
+namespace {
+constexpr int RESOLUTION = 19200;
+constexpr std::string_view SHORT_NAME = "song";
+// Section names are looked up from these pointers on every console.
+constexpr std::uint32_t INTRO_SECTION_POINTER = 0x001B546E;
+
+constexpr std::array<SightRead::Detail::Endianness, 2> ENDIANNESSES {
+    SightRead::Detail::Endianness::LittleEndian,
+    SightRead::Detail::Endianness::BigEndian};
+
+struct QbTestSong {
+    std::vector<std::uint32_t> fretbars;
+    std::vector<std::uint32_t> expert_notes;
+    std::vector<std::vector<std::uint32_t>> expert_phrases;
+    std::vector<QbTestMarker> markers;
+};
+
+// Fretbars every 500ms, so every beat is 120 BPM.
+std::vector<std::uint32_t> fretbars(std::uint32_t count)
+{
+    constexpr std::uint32_t BEAT_LENGTH_MS = 500;
+
+    std::vector<std::uint32_t> times;
+    for (auto i = 0U; i < count; ++i) {
+        times.push_back(i * BEAT_LENGTH_MS);
+    }
+    return times;
+}
+
+std::vector<std::uint8_t> qb_file(const QbTestSong& song,
+                                  SightRead::Detail::Endianness endianness)
+{
+    QbFileBuilder builder {endianness};
+    builder.integer_array("song_fretbars", song.fretbars)
+        .nested_integer_arrays("song_timesig", {{0, 4, 4}})
+        .markers("song_markers", song.markers);
+    for (auto difficulty : {"easy", "medium", "hard"}) {
+        builder.integer_array(std::string("song_song_") + difficulty, {})
+            .nested_integer_arrays(
+                std::string("song_") + difficulty + "_star", {});
+    }
+    builder.integer_array("song_song_expert", song.expert_notes)
+        .nested_integer_arrays("song_expert_star", song.expert_phrases);
+    return builder.bytes();
+}
+
+SightRead::Song convert(const std::vector<std::uint8_t>& data,
+                        SightRead::Detail::Endianness endianness)
+{
+    const auto midi = SightRead::Detail::parse_qb(data, endianness);
+    return SightRead::Detail::QbMidiConverter({}, SHORT_NAME).convert(midi);
+}
+}
+
+BOOST_AUTO_TEST_CASE(songs_are_read_in_either_endianness)
+{
+    const QbTestSong song {.fretbars = fretbars(9),
+                           .expert_notes = {0, 0, 1, 1000, 0, 2},
+                           .expert_phrases = {{0, 1500, 2}},
+                           .markers = {{.time_ms = 500,
+                                        .name = INTRO_SECTION_POINTER}}};
+    const std::vector<SightRead::Note> expected_notes {
+        make_note(0), make_note(2 * RESOLUTION, 0, SightRead::FIVE_FRET_RED)};
+    const std::vector<SightRead::StarPower> expected_phrases {
+        {SightRead::Tick {0}, SightRead::Tick {3 * RESOLUTION}}};
+    const std::vector<SightRead::PracticeSection> expected_sections {
+        {"Intro", SightRead::Tick {RESOLUTION}}};
+
+    for (auto endianness : ENDIANNESSES) {
+        const auto converted = convert(qb_file(song, endianness), endianness);
+        const auto& track = converted.track(SightRead::Instrument::Guitar,
+                                            SightRead::Difficulty::Expert);
+
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            track.notes().cbegin(), track.notes().cend(),
+            expected_notes.cbegin(), expected_notes.cend());
+        BOOST_CHECK_EQUAL_COLLECTIONS(
+            track.sp_phrases().cbegin(), track.sp_phrases().cend(),
+            expected_phrases.cbegin(), expected_phrases.cend());
+        const auto& sections = converted.global_data().practice_sections();
+        BOOST_CHECK_EQUAL_COLLECTIONS(sections.cbegin(), sections.cend(),
+                                      expected_sections.cbegin(),
+                                      expected_sections.cend());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(difficulties_without_notes_have_no_track)
+{
+    const QbTestSong song {.fretbars = fretbars(4),
+                           .expert_notes = {0, 0, 1},
+                           .expert_phrases = {},
+                           .markers = {}};
+
+    const auto converted
+        = convert(qb_file(song, SightRead::Detail::Endianness::BigEndian),
+                  SightRead::Detail::Endianness::BigEndian);
+
+    const auto difficulties
+        = converted.difficulties(SightRead::Instrument::Guitar);
+    BOOST_REQUIRE_EQUAL(difficulties.size(), 1U);
+    BOOST_CHECK(difficulties[0] == SightRead::Difficulty::Expert);
+}
+
+BOOST_AUTO_TEST_CASE(files_with_too_few_fretbars_throw)
+{
+    const QbTestSong song {.fretbars = {0},
+                           .expert_notes = {0, 0, 1},
+                           .expert_phrases = {},
+                           .markers = {}};
+
+    BOOST_CHECK_THROW(
+        [&] {
+            return convert(
+                qb_file(song, SightRead::Detail::Endianness::BigEndian),
+                SightRead::Detail::Endianness::BigEndian);
+        }(),
+        SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(sustains_spanning_many_fretbars_are_converted)
+{
+    const QbTestSong song {.fretbars = fretbars(100),
+                           .expert_notes = {0, 20000, 1, 1000, 0, 2},
+                           .expert_phrases = {{0, 25000, 1}},
+                           .markers = {}};
+    const std::vector<SightRead::Note> expected_notes {
+        make_note(0, 40 * RESOLUTION),
+        make_note(2 * RESOLUTION, 0, SightRead::FIVE_FRET_RED)};
+    const std::vector<SightRead::StarPower> expected_phrases {
+        {SightRead::Tick {0}, SightRead::Tick {50 * RESOLUTION}}};
+
+    const auto converted
+        = convert(qb_file(song, SightRead::Detail::Endianness::BigEndian),
+                  SightRead::Detail::Endianness::BigEndian);
+    const auto& track = converted.track(SightRead::Instrument::Guitar,
+                                        SightRead::Difficulty::Expert);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(track.notes().cbegin(), track.notes().cend(),
+                                  expected_notes.cbegin(),
+                                  expected_notes.cend());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        track.sp_phrases().cbegin(), track.sp_phrases().cend(),
+        expected_phrases.cbegin(), expected_phrases.cend());
+}
+
+BOOST_AUTO_TEST_CASE(short_sustains_are_cut)
+{
+    const QbTestSong song {.fretbars = fretbars(9),
+                           .expert_notes = {0, 250, 1, 1000, 500, 1},
+                           .expert_phrases = {},
+                           .markers = {}};
+    const std::vector<SightRead::Note> expected_notes {
+        make_note(0), make_note(2 * RESOLUTION, RESOLUTION)};
+
+    const auto converted
+        = convert(qb_file(song, SightRead::Detail::Endianness::BigEndian),
+                  SightRead::Detail::Endianness::BigEndian);
+    const auto& track = converted.track(SightRead::Instrument::Guitar,
+                                        SightRead::Difficulty::Expert);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(track.notes().cbegin(), track.notes().cend(),
+                                  expected_notes.cbegin(),
+                                  expected_notes.cend());
+}
+
+BOOST_AUTO_TEST_CASE(notes_past_the_last_fretbar_throw)
+{
+    const QbTestSong song {.fretbars = fretbars(4),
+                           .expert_notes = {0, 5000, 1},
+                           .expert_phrases = {},
+                           .markers = {}};
+
+    BOOST_CHECK_THROW(
+        [&] {
+            return convert(
+                qb_file(song, SightRead::Detail::Endianness::BigEndian),
+                SightRead::Detail::Endianness::BigEndian);
+        }(),
+        SightRead::ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(notes_past_the_last_fretbar_are_content_errors)
+{
+    const QbTestSong song {.fretbars = fretbars(4),
+                           .expert_notes = {0, 5000, 1},
+                           .expert_phrases = {},
+                           .markers = {}};
+    const auto data = qb_file(song, SightRead::Detail::Endianness::BigEndian);
+
+    const auto result
+        = SightRead::QbMidiParser({}, SHORT_NAME, SightRead::Console::Xbox360)
+              .try_parse(data);
+
+    BOOST_REQUIRE(!result.has_value());
+    BOOST_CHECK(result.error().category
+                == SightRead::ParseErrorCategory::Content);
+}
+
+BOOST_AUTO_TEST_CASE(event_limits_count_array_elements)
+{
+    constexpr std::size_t ITEM_COUNT = 11;
+
+    const QbTestSong song {.fretbars = fretbars(9),
+                           .expert_notes = {0, 0, 1, 1000, 0, 2},
+                           .expert_phrases = {},
+                           .markers = {}};
+    const auto data = qb_file(song, SightRead::Detail::Endianness::BigEndian);
+    SightRead::ParseLimits limits;
+    limits.max_events = ITEM_COUNT;
+
+    const auto result
+        = SightRead::QbMidiParser({}, SHORT_NAME, SightRead::Console::Xbox360)
+              .limits(limits)
+              .try_parse(data);
+
+    BOOST_REQUIRE(!result.has_value());
+    BOOST_CHECK(result.error().category
+                == SightRead::ParseErrorCategory::LimitExceeded);
+}
+
+BOOST_AUTO_TEST_CASE(event_limits_are_checked_while_reading)
+{
+    const QbTestSong song {.fretbars = fretbars(9),
+                           .expert_notes = {0, 0, 1, 1000, 0, 2},
+                           .expert_phrases = {},
+                           .markers = {}};
+    const auto data = qb_file(song, SightRead::Detail::Endianness::BigEndian);
+    SightRead::ParseLimits limits;
+    limits.max_events = 1;
+
+    const auto result = SightRead::Detail::try_parse_qb(
+        data, SightRead::Detail::Endianness::BigEndian,
+        SightRead::Detail::LimitChecker {limits});
+
+    BOOST_REQUIRE(!result.has_value());
+    BOOST_CHECK(result.error().category
+                == SightRead::ParseErrorCategory::LimitExceeded);
+}
+
+BOOST_AUTO_TEST_CASE(cyclic_files_return_diagnostics_within_limits)
+{
+    constexpr auto LAST_ITEM_OFFSET = 84;
+    constexpr auto LAST_NEXT_ITEM_OFFSET = 99;
+    constexpr auto ARRAY_OFFSET = 48;
+    constexpr auto LIST_START_OFFSET = 59;
+
+    auto cyclic_struct
+        = QbFileBuilder {SightRead::Detail::Endianness::BigEndian}
+              .markers("markers", {{.time_ms = 0, .name = std::uint32_t {1}}})
+              .bytes();
+    cyclic_struct.at(LAST_NEXT_ITEM_OFFSET) = LAST_ITEM_OFFSET;
+    auto self_nested_array
+        = QbFileBuilder {SightRead::Detail::Endianness::BigEndian}
+              .nested_integer_arrays("nested", {{1, 2}})
+              .bytes();
+    self_nested_array.at(LIST_START_OFFSET) = ARRAY_OFFSET;
+    SightRead::ParseLimits limits;
+    limits.time_budget = std::chrono::milliseconds {100};
+    limits.max_events = 1000;
+
+    for (const auto& data : {cyclic_struct, self_nested_array}) {
+        const auto result = SightRead::QbMidiParser({}, SHORT_NAME,
+                                                    SightRead::Console::Xbox360)
+                                .limits(limits)
+                                .try_parse(data);
+
+        BOOST_REQUIRE(!result.has_value());
+        BOOST_CHECK(result.error().category
+                    == SightRead::ParseErrorCategory::Syntax);
+    }
+}
@@ -1,8 +1,13 @@
+#include <cstddef>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
 #include "sightread/detail/stringutil.hpp"
+#include "sightread/tempomap.hpp"
 
 BOOST_AUTO_TEST_CASE(break_off_newline_works_correctly)
 {
@@ -21,6 +26,40 @@ BOOST_AUTO_TEST_CASE(skip_whitespace_works_correctly)
     BOOST_CHECK_EQUAL(SightRead::Detail::skip_whitespace("H  ello"), "H  ello");
 }
 
+BOOST_AUTO_TEST_CASE(find_newline_finds_every_newline)
+{
+    const std::string text {"\nA line longer than sixteen bytes\n\n\rTail\n"};
+    const std::vector<std::size_t> expected_positions {0, 33, 34, 40};
+
+    std::vector<std::size_t> positions;
+    for (auto position = SightRead::Detail::find_newline(text, 0);
+         position != std::string_view::npos;
+         position = SightRead::Detail::find_newline(text, position + 1)) {
+        positions.push_back(position);
+    }
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(positions.cbegin(), positions.cend(),
+                                  expected_positions.cbegin(),
+                                  expected_positions.cend());
+}
+
+BOOST_AUTO_TEST_CASE(line_reader_matches_break_off_newline)
+{
+    const std::string_view text
+        = "First\r\n  \n\tSecond line that is long\rstill\r\n\r\nLast";
+    std::string_view data = text;
+    SightRead::Detail::LineReader reader {text};
+
+    while (!data.empty()) {
+        BOOST_REQUIRE(!reader.empty());
+        BOOST_CHECK_EQUAL(reader.next_line(),
+                          SightRead::Detail::break_off_newline(data));
+    }
+    BOOST_TEST(reader.empty());
+    BOOST_CHECK_THROW([&] { return reader.next_line(); }(),
+                      SightRead::ParseError);
+}
+
 BOOST_AUTO_TEST_CASE(to_utf8_string_strips_utf8_bom)
 {
     const std::string text {"\xEF\xBB\xBF\x6E"};
@@ -51,3 +90,74 @@ BOOST_AUTO_TEST_CASE(to_utf8_string_correctly_converts_from_latin_1_strings)
 
     BOOST_CHECK_EQUAL(SightRead::Detail::to_utf8_string(text), "é0");
 }
+
+BOOST_AUTO_TEST_CASE(to_utf8_view_does_not_copy_utf8_strings)
+{
+    const std::string text {"\xEF\xBB\xBFSong name \xC3\xA9 with an accent"};
+    std::string buffer;
+
+    const auto view = SightRead::Detail::to_utf8_view(text, buffer);
+
+    BOOST_CHECK_EQUAL(view, "Song name é with an accent");
+    BOOST_CHECK_EQUAL(static_cast<const void*>(view.data()),
+                      static_cast<const void*>(text.data() + 3));
+    BOOST_TEST(buffer.empty());
+}
+
+BOOST_AUTO_TEST_CASE(to_utf8_view_stores_converted_strings_in_buffer)
+{
+    const std::string text {"\xE9\x30"};
+    std::string buffer;
+
+    const auto view = SightRead::Detail::to_utf8_view(text, buffer);
+
+    BOOST_CHECK_EQUAL(view, "é0");
+    BOOST_CHECK_EQUAL(static_cast<const void*>(view.data()),
+                      static_cast<const void*>(buffer.data()));
+}
+
+BOOST_AUTO_TEST_CASE(is_valid_utf8_accepts_valid_utf8)
+{
+    BOOST_TEST(SightRead::Detail::is_valid_utf8(""));
+    BOOST_TEST(SightRead::Detail::is_valid_utf8("Plain ASCII text"));
+    BOOST_TEST(SightRead::Detail::is_valid_utf8("\xC2\xA9"));
+    BOOST_TEST(SightRead::Detail::is_valid_utf8("\xE0\xA0\x80\xED\x9F\xBF"));
+    BOOST_TEST(SightRead::Detail::is_valid_utf8(
+        "Sixteen ASCII bytes then \xF0\x90\x80\x80\xF4\x8F\xBF\xBF"));
+}
+
+BOOST_AUTO_TEST_CASE(is_valid_utf8_rejects_invalid_utf8)
+{
+    // Lone continuation byte, overlong encodings, a surrogate, a code point
+    // past U+10FFFF, and a truncated sequence.
+    BOOST_TEST(!SightRead::Detail::is_valid_utf8("abc\x80"));
+    BOOST_TEST(!SightRead::Detail::is_valid_utf8("\xC0\xAF"));
+    BOOST_TEST(!SightRead::Detail::is_valid_utf8("\xE0\x9F\xBF"));
+    BOOST_TEST(!SightRead::Detail::is_valid_utf8("\xED\xA0\x80"));
+    BOOST_TEST(!SightRead::Detail::is_valid_utf8("\xF4\x90\x80\x80"));
+    BOOST_TEST(!SightRead::Detail::is_valid_utf8("\xE2\x82"));
+}
+
+BOOST_AUTO_TEST_CASE(utf16_to_utf8_converts_every_plane)
+{
+    const std::u16string text {u"Long enough for a block: é€\U0001F3B8"};
+
+    BOOST_CHECK_EQUAL(SightRead::Detail::utf16_to_utf8(text),
+                      "Long enough for a block: \xC3\xA9\xE2\x82\xAC"
+                      "\xF0\x9F\x8E\xB8");
+}
+
+BOOST_AUTO_TEST_CASE(utf16_to_utf8_skips_unpaired_surrogates)
+{
+    const std::u16string text {u'a', 0xDC00, u'b', 0xD800, u'c', u'd', 0xD800};
+
+    BOOST_CHECK_EQUAL(SightRead::Detail::utf16_to_utf8(text), "abd");
+}
+
+BOOST_AUTO_TEST_CASE(latin1_to_utf8_converts_high_bytes)
+{
+    const std::string text {"Sixteen plain bytes then \xE9\xFF and \xA0"};
+
+    BOOST_CHECK_EQUAL(SightRead::Detail::latin1_to_utf8(text),
+                      "Sixteen plain bytes then \xC3\xA9\xC3\xBF and \xC2\xA0");
+}
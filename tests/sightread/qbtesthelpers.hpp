@@ -0,0 +1,232 @@
+#ifndef SIGHTREAD_QBTESTHELPERS_HPP
+#define SIGHTREAD_QBTESTHELPERS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "sightread/detail/qbmidi.hpp"
+
+// The CRC-32 QB files use for ids, which is not inverted at the end.
+inline std::uint32_t qb_crc(std::string_view key)
+{
+    constexpr std::uint32_t POLYNOMIAL = 0xEDB88320;
+
+    std::uint32_t crc = ~0U;
+    for (const auto character : key) {
+        crc ^= static_cast<std::uint8_t>(character);
+        for (auto i = 0; i < 8; ++i) {
+            crc = (crc >> 1U) ^ ((crc & 1U) != 0 ? POLYNOMIAL : 0U);
+        }
+    }
+    return crc;
+}
+
+struct QbTestMarker {
+    std::int32_t time_ms;
+    // Either the section's name or a pointer to a known section name.
+    std::variant<std::u16string, std::uint32_t> name;
+};
+
+// Writes .mid.qb files laid out as the games lay them out, so tests can build
+// files item by item. Items are given the id of the CRC of their key.
+class QbFileBuilder {
+private:
+    static constexpr std::uint8_t STRUCT_FLAG_TYPE = 0;
+    static constexpr std::uint8_t INTEGER_TYPE = 1;
+    static constexpr std::uint8_t STRUCT_TYPE = 10;
+    static constexpr std::uint8_t ARRAY_TYPE = 12;
+
+    SightRead::Detail::Endianness m_endianness;
+    std::vector<std::uint8_t> m_data;
+
+    [[nodiscard]] std::uint32_t position() const
+    {
+        return static_cast<std::uint32_t>(m_data.size());
+    }
+
+    void write_at(std::size_t offset, std::uint32_t value)
+    {
+        for (auto i = 0U; i < 4; ++i) {
+            const auto shift = m_endianness
+                    == SightRead::Detail::Endianness::BigEndian
+                ? 8 * (3 - i)
+                : 8 * i;
+            m_data.at(offset + i) = static_cast<std::uint8_t>(value >> shift);
+        }
+    }
+
+    void write(std::uint32_t value)
+    {
+        m_data.resize(m_data.size() + 4);
+        write_at(m_data.size() - 4, value);
+    }
+
+    void write_wide_char(char16_t character)
+    {
+        const auto high = static_cast<std::uint8_t>(character >> 8);
+        const auto low = static_cast<std::uint8_t>(character);
+        if (m_endianness == SightRead::Detail::Endianness::BigEndian) {
+            m_data.push_back(high);
+            m_data.push_back(low);
+        } else {
+            m_data.push_back(low);
+            m_data.push_back(high);
+        }
+    }
+
+    // Item info is always little endian.
+    void write_info(std::uint8_t flags, std::uint8_t type)
+    {
+        m_data.push_back(0);
+        m_data.push_back(flags);
+        m_data.push_back(type);
+        m_data.push_back(0);
+    }
+
+    void write_item_header(std::string_view key)
+    {
+        write_info(0, ARRAY_TYPE);
+        write(qb_crc(key));
+        write(0);
+        write(0);
+        write(0);
+    }
+
+    void write_empty_array()
+    {
+        write_info(0, STRUCT_FLAG_TYPE);
+        write(0);
+        write(0);
+    }
+
+    void write_integer_node(const std::vector<std::uint32_t>& values)
+    {
+        write_info(0, INTEGER_TYPE);
+        write(static_cast<std::uint32_t>(values.size()));
+        if (values.size() > 1) {
+            write(position() + 4);
+        }
+        for (auto value : values) {
+            write(value);
+        }
+    }
+
+    // Writes the offsets of count nodes, returning where the offsets are so
+    // they can be filled in as the nodes are written.
+    std::size_t write_node_list(std::size_t count)
+    {
+        write(position() + 4);
+        const auto list_position = m_data.size();
+        if (count > 1) {
+            m_data.resize(m_data.size() + 4 * count);
+        }
+        return list_position;
+    }
+
+    void write_marker(const QbTestMarker& marker)
+    {
+        const auto is_big_endian
+            = m_endianness == SightRead::Detail::Endianness::BigEndian;
+        const std::uint8_t integer_type = is_big_endian ? 1 : 3;
+        const std::uint8_t pointer_type = is_big_endian ? 26 : 53;
+        const std::uint8_t wide_string_type = 4;
+
+        write(0);
+        write(position() + 4);
+
+        write_info(1, integer_type);
+        write(qb_crc("time"));
+        write(static_cast<std::uint32_t>(marker.time_ms));
+        write(position() + 4);
+
+        if (const auto* pointer = std::get_if<std::uint32_t>(&marker.name)) {
+            write_info(1, pointer_type);
+            write(qb_crc("marker"));
+            write(*pointer);
+            write(0);
+            return;
+        }
+        write_info(1, wide_string_type);
+        write(qb_crc("marker"));
+        write(0);
+        write(0);
+        for (auto character : std::get<std::u16string>(marker.name)) {
+            write_wide_char(character);
+        }
+        write_wide_char(0);
+        m_data.resize((m_data.size() + 3) & ~std::size_t {3});
+    }
+
+public:
+    explicit QbFileBuilder(SightRead::Detail::Endianness endianness)
+        : m_endianness {endianness}
+    {
+        constexpr auto HEADER_SIZE = 28U;
+
+        m_data.resize(HEADER_SIZE);
+    }
+
+    QbFileBuilder& integer_array(std::string_view key,
+                                 const std::vector<std::uint32_t>& values)
+    {
+        write_item_header(key);
+        if (values.empty()) {
+            write_empty_array();
+        } else {
+            write_integer_node(values);
+        }
+        return *this;
+    }
+
+    QbFileBuilder&
+    nested_integer_arrays(std::string_view key,
+                          const std::vector<std::vector<std::uint32_t>>& arrays)
+    {
+        write_item_header(key);
+        if (arrays.empty()) {
+            write_empty_array();
+            return *this;
+        }
+        write_info(0, ARRAY_TYPE);
+        write(static_cast<std::uint32_t>(arrays.size()));
+        const auto list_position = write_node_list(arrays.size());
+        for (auto i = 0U; i < arrays.size(); ++i) {
+            if (arrays.size() > 1) {
+                write_at(list_position + 4 * i, position());
+            }
+            write_integer_node(arrays[i]);
+        }
+        return *this;
+    }
+
+    QbFileBuilder& markers(std::string_view key,
+                           const std::vector<QbTestMarker>& markers)
+    {
+        write_item_header(key);
+        if (markers.empty()) {
+            write_empty_array();
+            return *this;
+        }
+        write_info(0, STRUCT_TYPE);
+        write(static_cast<std::uint32_t>(markers.size()));
+        const auto list_position = write_node_list(markers.size());
+        for (auto i = 0U; i < markers.size(); ++i) {
+            if (markers.size() > 1) {
+                write_at(list_position + 4 * i, position());
+            }
+            write_marker(markers[i]);
+        }
+        return *this;
+    }
+
+    [[nodiscard]] const std::vector<std::uint8_t>& bytes() const
+    {
+        return m_data;
+    }
+};
+
+#endif